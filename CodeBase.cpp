@@ -6,1278 +6,10024 @@
 #include <vector>
 #include <string>
 #include <ctime>
+#include <chrono>
+#include <stdexcept>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_set>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <queue>
+#include <deque>
+#include <list>
+#include <map>
+#include <array>
+#include <memory_resource>
+#include <charconv>
+#include <cmath>
+#include <bit>
+#include <optional>
+#include <utility>
+#include <coroutine>
+#include <filesystem>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef _WIN32
+#include <iterator>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <cerrno>
+extern char **environ;
+#endif
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define FLOW_IO_URING 1
+#endif
 using namespace std;
 
-class FlowStep
+// Ca asctime(localtime(...)), dar fara bufferul static, deci se poate apela din mai multe fire.
+// Textul ultimei secunde e pastrat pe fir, pasii terminati in aceeasi secunda nu mai apeleaza localtime.
+string timeText(time_t moment)
 {
-protected:
-    string name;
-    string description;
-    bool executed;
-    bool skipped;
-    int errors = 0;
+    thread_local time_t second = -1;
+    thread_local char text[32];
+    if (moment != second)
+    {
+        tm local;
+#ifdef _WIN32
+        localtime_s(&local, &moment);
+#else
+        localtime_r(&moment, &local);
+#endif
+        strftime(text, sizeof(text), "%a %b %d %H:%M:%S %Y\n", &local);
+        second = moment;
+    }
+    return text;
+}
 
-public:
-    FlowStep(string Name, string Description) : name(Name), description(Description), executed(false), skipped(false) {}
+// Contor care poate fi incrementat din mai multe fire; o copie preia valoarea curenta
+class SharedCounter
+{
+private:
+    atomic<int> value{0};
 
-    string getName()
+public:
+    SharedCounter() = default;
+    SharedCounter(const SharedCounter &other) : value(other.value.load()) {}
+    SharedCounter &operator=(const SharedCounter &other)
     {
-        return name;
+        value = other.value.load();
+        return *this;
     }
-    string getDescription()
+    SharedCounter &operator=(int Value)
     {
-        return description;
+        value = Value;
+        return *this;
+    }
+    SharedCounter &operator+=(int amount)
+    {
+        value.fetch_add(amount, memory_order_relaxed);
+        return *this;
+    }
+    void operator++(int)
+    {
+        value.fetch_add(1, memory_order_relaxed);
+    }
+    operator int() const
+    {
+        return value.load(memory_order_relaxed);
     }
-    virtual void setState(bool Executed) { executed = Executed; }
+};
 
-    virtual bool getState() { return executed; }
+// Iesirea consolei si jurnalul sunt scrise de un fir separat. Fiecare fir care scrie are un inel propriu
+// (un producator, un consumator, fara lock), iar firul de scriere goleste toate inelele cu un singur writev.
+// Astfel endl nu mai inseamna un apel de sistem pe linie si pasul nu asteapta dupa terminal.
+class AsyncSink
+{
+public:
+    static constexpr size_t RingSize = 1 << 16;
+    static constexpr size_t MaxRings = 64;
+    static constexpr chrono::microseconds Pause{500};
 
-    virtual int getError() { return errors; }
+private:
+    struct Ring
+    {
+        alignas(64) atomic<size_t> head{0}; // octetii scrisi deja in fisier
+        alignas(64) atomic<size_t> tail{0}; // octetii publicati de producator
+        atomic<bool> owned{false};
+        char data[RingSize];
+    };
 
-    virtual bool getSkipped() { return skipped; }
+    // Inelele firului curent, cate unul pentru fiecare sink; eliberate cand firul se termina
+    struct ThreadRings
+    {
+        Ring *rings[2] = {};
+        ~ThreadRings()
+        {
+            for (Ring *ring : rings)
+            {
+                if (ring != nullptr)
+                    ring->owned.store(false, memory_order_release);
+            }
+        }
+    };
 
-    virtual void execute() = 0;
+    int fd;
+    size_t id; // pozitia in ThreadRings
+    unique_ptr<Ring> rings[MaxRings];
+    atomic<size_t> ringCount{0};
+    mutex sharedLock; // pentru firele care nu mai gasesc un inel liber: folosesc impreuna ultimul inel
+    atomic<uint32_t> signal{0};
+    atomic<bool> idle{false}, urgent{false}, stopping{false};
+    mutex pauseLock;
+    condition_variable pause;
+    thread writer;
+    once_flag started;
 
-    virtual void displayDetails()
+    Ring *claim()
     {
-        cout << endl;
-        cout << "Step name: " << name << "\n";
-        cout << "Description: " << description << "\n";
+        for (size_t i = 0; i + 1 < MaxRings; i++)
+        {
+            bool expected = false;
+            if (rings[i]->owned.compare_exchange_strong(expected, true, memory_order_acquire))
+            {
+                size_t count = ringCount.load();
+                while (count < i + 1 && !ringCount.compare_exchange_weak(count, i + 1))
+                {
+                }
+                return rings[i].get();
+            }
+        }
+        return nullptr;
     }
 
-    virtual bool validateInput(string input) { return true; }
+    void wake()
+    {
+        signal.fetch_add(1);
+        signal.notify_one();
+    }
 
-    virtual string extractInfo() { return " "; }
+    // Scurteaza pauza firului de scriere: cineva asteapta dupa el sau un inel e pe jumatate plin
+    void hurry()
+    {
+        if (!urgent.exchange(true))
+        {
+            lock_guard<mutex> guard(pauseLock);
+            pause.notify_one();
+        }
+        wake();
+    }
 
-    // Functie care ii da utilizatorului posibilitatea de a da skip unei etape
-    virtual bool Skip()
+    bool writeAll(const string_view *views, int count)
     {
-        string input;
-        cout << "Write yes if you want to skip this step or no if you don't want to skip this step: " << endl;
-        while (true)
+#ifdef _WIN32
+        for (int i = 0; i < count; i++)
         {
-            getline(cin, input);
-            if (input.find_first_not_of(' ') == string::npos)
+            string_view part = views[i];
+            while (!part.empty())
             {
-                cout << "Input should not be empty. Try again: "; // pt cand apasa doar enter
+                int written = _write(fd, part.data(), static_cast<unsigned>(part.size()));
+                if (written <= 0)
+                    return false;
+                part.remove_prefix(written);
             }
-            else if (input == "yes")
+        }
+        return true;
+#else
+        iovec parts[2 * MaxRings];
+        for (int i = 0; i < count; i++)
+            parts[i] = {const_cast<char *>(views[i].data()), views[i].size()};
+        int index = 0;
+        while (index < count)
+        {
+            ssize_t written = ::writev(fd, parts + index, count - index);
+            if (written < 0)
             {
-                cout << "Step skipped." << endl;
-                skipped = true;
-                return true;
+                if (errno == EINTR)
+                    continue;
+                return false;
             }
-            else if (input == "no")
+            while (index < count && static_cast<size_t>(written) >= parts[index].iov_len)
             {
-                return false;
+                written -= parts[index].iov_len;
+                index++;
             }
-            else
+            if (index < count)
             {
-                cout << "Invalid input. Try again: ";
+                parts[index].iov_base = static_cast<char *>(parts[index].iov_base) + written;
+                parts[index].iov_len -= written;
             }
         }
+        return true;
+#endif
     }
 
-    virtual void displayProgress() {}
-
-    void ifError(const invalid_argument &e)
+    // Scrie tot ce au publicat inelele; intoarce numarul de octeti scrisi
+    size_t drain()
     {
-        int c;
-        cout << "Error: " << e.what() << endl;
-        cout << "Choose if you want to reload the step or go to the next one " << endl;
-        cout << "\t|    Press 1 to Reload the Step                 |" << endl;
-        cout << "\t|    Press 2 to Go to the next Step             |" << endl;
-        cin >> c;
-        switch (c)
+        string_view parts[2 * MaxRings];
+        size_t upTo[MaxRings];
+        int count = 0;
+        size_t bytes = 0, rings = ringCount.load();
+        for (size_t i = 0; i < rings; i++)
         {
-        case 1:
-            cin.ignore();
-            execute();
-            break;
-        case 2:
-            cin.ignore();
-            skipped = true;
-            break;
-        default:
-            system("cls");
-            cout << "\t\t\t Please select from the options given above \n"
-                 << endl;
+            Ring &ring = *this->rings[i];
+            size_t head = ring.head.load(memory_order_relaxed);
+            upTo[i] = ring.tail.load(memory_order_acquire);
+            if (upTo[i] == head)
+                continue;
+            size_t start = head % RingSize, length = upTo[i] - head;
+            size_t first = min(length, RingSize - start);
+            parts[count++] = {ring.data + start, first};
+            if (first < length)
+                parts[count++] = {ring.data, length - first};
+            bytes += length;
         }
+        if (bytes == 0)
+            return 0;
+        writeAll(parts, count); // daca iesirea s-a inchis textul se pierde, ca la cout
+        for (size_t i = 0; i < rings; i++)
+        {
+            Ring &ring = *this->rings[i];
+            if (ring.head.load(memory_order_relaxed) != upTo[i])
+            {
+                ring.head.store(upTo[i], memory_order_release);
+                ring.head.notify_all();
+            }
+        }
+        return bytes;
     }
 
-    virtual ~FlowStep() = default;
-};
-
-class TitleStep : public FlowStep
-{
-private:
-    string title, subtitle;
-
-public:
-    TitleStep(string name, string description) : FlowStep(name, description) {}
-
-    bool validateInput(string input) override
+    bool pending() const
     {
-        if (input == "" || input.length() < 2 || input.length() > 50 || input.find_first_not_of(' ') == string::npos)
-            return false;
-        return true;
+        size_t rings = ringCount.load();
+        for (size_t i = 0; i < rings; i++)
+        {
+            if (this->rings[i]->head.load() != this->rings[i]->tail.load())
+                return true;
+        }
+        return false;
     }
 
-    void execute() override
+    // Dupa o scriere firul face o pauza scurta (Pause), ca liniile scrise intre timp sa plece impreuna.
+    // Fara pauza, pe un program care scrie linie cu linie fiecare linie ar trezi firul si ar face un write.
+    void writeLoop()
     {
-        displayDetails();
-        if (Skip())
-        {
-            return;
-        }
-        else
+        while (true)
         {
-            try
-            {
-                cout << "\tEnter the title : " << endl;
-                getline(cin, title);
-                if (validateInput(title) == false)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid title. Title cannot be empty and must have between 2 and 50 characters.");
-                }
-                cout << "\tEnter the subtitle : " << endl;
-                getline(cin, subtitle);
-                if (validateInput(subtitle) == false)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid subtitle. Subtitle cannot be empty and must have between 2 and 50 characters.");
-                }
-
-                executed = true;
-            }
-            catch (const invalid_argument &e)
+            if (drain() != 0)
             {
-                title = "";
-                subtitle = "";
-                ifError(e);
+                unique_lock<mutex> guard(pauseLock);
+                pause.wait_for(guard, Pause, [this]
+                               { return urgent.load() || stopping.load(); });
+                urgent.store(false);
+                continue;
             }
+            if (stopping.load())
+                break;
+            uint32_t seen = signal.load();
+            idle.store(true);
+            if (!pending() && !stopping.load())
+                signal.wait(seen);
+            idle.store(false);
         }
     }
 
-    void displayProgress() override
+    // Asteapta pana cand firul de scriere a ajuns la octetul upTo din inel
+    void waitFor(Ring &ring, size_t upTo)
     {
-        time_t now = time(nullptr);
-        if (title.empty() && subtitle.empty())
+        size_t head = ring.head.load(memory_order_acquire);
+        while (upTo > head)
         {
-            return;
+            hurry();
+            ring.head.wait(head, memory_order_acquire);
+            head = ring.head.load(memory_order_acquire);
         }
-        cout << "TitleStep completed with title: " << title << " and subtitle: " << subtitle << endl;
-        cout << "Number of error screens displayed: " << errors << endl;
-        cout << "Completion time: " << asctime(localtime(&now)) << endl;
     }
 
-    string extractInfo() override
+    void append(Ring &ring, string_view text)
     {
-        if (title.empty() && subtitle.empty())
+        while (!text.empty())
         {
-            return "Title and subtitle are empty.";
+            size_t tail = ring.tail.load(memory_order_relaxed);
+            if (tail - ring.head.load(memory_order_acquire) == RingSize)
+                waitFor(ring, tail - RingSize + 1);
+            size_t space = RingSize - (tail - ring.head.load(memory_order_acquire));
+            size_t start = tail % RingSize;
+            size_t length = min({text.size(), space, RingSize - start});
+            memcpy(ring.data + start, text.data(), length);
+            ring.tail.store(tail + length); // seq_cst: impreuna cu idle, firul de scriere nu adoarme cu text nepublicat
+            text.remove_prefix(length);
         }
-        return title + " " + subtitle;
+        if (idle.load())
+            wake();
+        else if (ring.tail.load(memory_order_relaxed) - ring.head.load(memory_order_relaxed) > RingSize / 2 && !urgent.load(memory_order_relaxed))
+            hurry();
     }
-};
 
-class TextStep : public FlowStep
-{
-private:
-    string title, copy;
+    Ring *ringOfThread()
+    {
+        thread_local ThreadRings local;
+        Ring *&ring = local.rings[id];
+        if (ring == nullptr)
+        {
+            call_once(started, [this]
+                      { writer = thread([this]
+                                        { writeLoop(); }); });
+            ring = claim();
+        }
+        return ring;
+    }
 
 public:
-    TextStep(string name, string description) : FlowStep(name, description) {}
-
-    bool validateInput(string input) override
+    AsyncSink(int Fd, size_t Id) : fd(Fd), id(Id)
     {
-        if (input == "" || input.length() < 2 || input.find_first_not_of(' ') == string::npos)
-            return false;
-        return true;
+        for (auto &ring : rings)
+            ring = make_unique<Ring>();
+        rings[MaxRings - 1]->owned = true;
     }
-
-    void execute() override
+    AsyncSink(const AsyncSink &) = delete;
+    ~AsyncSink()
     {
-        displayDetails();
-        if (Skip())
-        {
-            return;
-        }
-        else
-        {
-            try
-            {
-
-                cout << "\tEnter the title : " << endl;
-                getline(cin, title);
-                if (validateInput(title) == false || title.length() > 50)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid title. Title cannot be empty and must have between 2 and 50 characters.");
-                }
-
-                cout << "\tEnter text : " << endl;
-                getline(cin, copy);
-                if (validateInput(copy) == false || copy.length() > 100)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid text. Text cannot be empty and must have between 2 and 100 characters.");
-                }
-                executed = true;
-            }
-            catch (const invalid_argument &e)
-            {
-                title = "";
-                copy = "";
-                ifError(e);
-            }
-        }
+        stopping.store(true);
+        hurry();
+        if (writer.joinable())
+            writer.join();
+        drain();
     }
 
-    string extractInfo() override
+    void write(string_view text)
     {
-        if (title.empty() && copy.empty())
+        if (Ring *ring = ringOfThread())
+            append(*ring, text);
+        else
         {
-            return "Title and copy are empty.";
+            lock_guard<mutex> guard(sharedLock);
+            ringCount.store(MaxRings);
+            append(*rings[MaxRings - 1], text);
         }
-        return title + "\n" + copy;
     }
 
-    void displayProgress() override
+    // Asteapta pana cand tot ce a scris firul curent a ajuns in fisier (de ex. inainte de a citi un raspuns)
+    void flush()
     {
-        if (title.empty() && copy.empty())
+        if (Ring *ring = ringOfThread())
+            waitFor(*ring, ring->tail.load(memory_order_relaxed));
+        else
         {
-            return;
+            lock_guard<mutex> guard(sharedLock);
+            waitFor(*rings[MaxRings - 1], rings[MaxRings - 1]->tail.load());
         }
-        time_t now = time(nullptr);
-        cout << "TextStep completed with title: " << title << " and copy: " << copy << endl;
-        cout << "Number of error screens displayed: " << errors << endl;
-        cout << "Completion time: " << asctime(localtime(&now)) << endl;
     }
-};
-
-class TextInputStep : public FlowStep
-{
-private:
-    string desc, text_input;
-
-public:
-    TextInputStep(string name, string description) : FlowStep(name, description) {}
 
-    bool validateInput(string input) override
+    static AsyncSink &console()
     {
-        if (input == "" || input.length() < 2 || input.find_first_not_of(' ') == string::npos)
-            return false;
-        return true;
+        static AsyncSink sink(1, 0);
+        return sink;
     }
 
-    void execute() override
+    // Adaptor pentru ostream: cout scrie in sink, iar endl (sync) nu mai face flush
+    class Buffer : public streambuf
     {
-        displayDetails();
-        if (Skip())
+    private:
+        AsyncSink &sink;
+        streambuf *previous = nullptr;
+        ostream *attached = nullptr;
+
+    protected:
+        streamsize xsputn(const char *text, streamsize count) override
         {
-            return;
+            sink.write(string_view(text, static_cast<size_t>(count)));
+            return count;
         }
-        else
+        int_type overflow(int_type c) override
         {
-            try
-            {
-                cout << "\tEnter text : " << endl;
-                getline(cin, text_input);
-                if (validateInput(text_input) == false || text_input.length() > 50)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid text. Text cannot be empty and must have between 2 and 50 characters.");
-                }
-                cout << "\tEnter description : " << endl;
-                getline(cin, desc);
-                if (validateInput(desc) == false || desc.length() > 200)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid description. Description cannot be empty and must have between 2 and 200 characters.");
-                }
-                executed = true;
-            }
-            catch (const invalid_argument &e)
+            if (c != traits_type::eof())
             {
-                desc = "";
-                text_input = "";
-                ifError(e);
+                char ch = traits_type::to_char_type(c);
+                sink.write(string_view(&ch, 1));
             }
+            return traits_type::not_eof(c);
         }
-    }
 
-    string extractInfo() override
-    {
-        if (desc.empty() && text_input.empty())
+    public:
+        Buffer(AsyncSink &Sink) : sink(Sink) {}
+        ~Buffer()
         {
-            return "Text input and description are empty.";
+            detach();
         }
-        return text_input + "\n" + desc; // sau return text_input ;
-    }
 
-    void displayProgress() override
-    {
-        if (desc.empty() && text_input.empty())
+        void attach(ostream &out)
         {
-            return;
+            out.flush();
+            previous = out.rdbuf(this);
+            attached = &out;
         }
-        time_t now = time(nullptr);
-        cout << "TextInputStep completed with textInput: " << text_input << " and description: " << desc << endl;
-        cout << "Number of error screens displayed: " << errors << endl;
-        cout << "Completion time: " << asctime(localtime(&now)) << endl;
+        void detach()
+        {
+            if (attached != nullptr)
+            {
+                sink.flush();
+                attached->rdbuf(previous);
+                attached = nullptr;
+            }
+        }
+    };
+
+    // cout trece prin consola asincrona pana la iesirea din program
+    static void attachConsole()
+    {
+        static Buffer buffer(console());
+        buffer.attach(cout);
     }
 };
 
-class NumberInputStep : public FlowStep
+enum class LogLevel : uint8_t
+{
+    Quiet, // nimic, de ex. pentru rularile fara utilizator
+    Error,
+    Warning,
+    Info,
+    Debug
+};
+
+// Jurnalul programului: linii cu ora si nivelul, scrise asincron in stderr sau intr-un fisier (--log-file)
+class Log
 {
 private:
-    string desc;
-    float number = 0;
+    static inline atomic<LogLevel> level{LogLevel::Warning};
+    static inline int fd = 2;
 
-public:
-    NumberInputStep(string name, string description) : FlowStep(name, description) {}
+    static AsyncSink &sink()
+    {
+        static AsyncSink sink(fd, 1);
+        return sink;
+    }
 
-    float getNumber()
+    // Ora in format text se recalculeaza doar cand se schimba secunda (localtime_r e scump)
+    static string_view stamp(char (&text)[32])
     {
-        return number;
+        thread_local time_t second = -1;
+        thread_local char cached[24];
+        auto now = chrono::system_clock::now();
+        time_t moment = chrono::system_clock::to_time_t(now);
+        if (moment != second)
+        {
+            tm local;
+#ifdef _WIN32
+            localtime_s(&local, &moment);
+#else
+            localtime_r(&moment, &local);
+#endif
+            strftime(cached, sizeof(cached), "%Y-%m-%d %H:%M:%S", &local);
+            second = moment;
+        }
+        int milliseconds = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+        int length = snprintf(text, sizeof(text), "%s.%03d", cached, milliseconds);
+        return string_view(text, static_cast<size_t>(length));
     }
-    void setNumber(float Number)
+
+public:
+    static void setLevel(LogLevel Level)
     {
-        number = Number;
+        level.store(Level, memory_order_relaxed);
     }
-    void setDescription(string s)
+
+    static bool parseLevel(string_view text, LogLevel &value)
     {
-        desc = s;
+        static const pair<string_view, LogLevel> names[] = {{"quiet", LogLevel::Quiet}, {"error", LogLevel::Error}, {"warning", LogLevel::Warning}, {"info", LogLevel::Info}, {"debug", LogLevel::Debug}};
+        for (auto &[name, named] : names)
+        {
+            if (name == text)
+            {
+                value = named;
+                return true;
+            }
+        }
+        return false;
     }
 
-    // template <typename T>
-    bool validateInput(string input)
+    // Trebuie apelat inainte de primul mesaj
+    static bool openFile(const string &fileName)
     {
-        if (input == "" || input.length() > 200 || input.length() < 2)
+#ifdef _WIN32
+        int opened = _open(fileName.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        int opened = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+        if (opened < 0)
             return false;
+        fd = opened;
         return true;
     }
-    bool validateInput2(string input)
+
+    static bool enabled(LogLevel messageLevel)
     {
-        for (char ch : input)
-        {
-            if (!isdigit(ch) && ch != '.')
-                return false;
-        }
-        return true;
+        return messageLevel != LogLevel::Quiet && messageLevel <= level.load(memory_order_relaxed);
     }
 
-    void execute() override
+    static void write(LogLevel messageLevel, string_view message)
     {
-        displayDetails();
-        if (Skip())
-        {
+        if (!enabled(messageLevel))
             return;
-        }
-        else
-        {
-            try
-            {
-                string input;
-                cout << "\tEnter number:  " << endl;
-                getline(cin, input);
+        static constexpr const char *names[] = {"", "ERROR", "WARN", "INFO", "DEBUG"};
+        char text[32];
+        string line;
+        line.reserve(message.size() + 40);
+        line += stamp(text);
+        line += ' ';
+        line += names[static_cast<int>(messageLevel)];
+        line += ' ';
+        line += message;
+        line += '\n';
+        sink().write(line);
+    }
 
-                if (validateInput2(input) == false)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid number.");
-                }
-                number = stof(input);
+    static void error(string_view message) { write(LogLevel::Error, message); }
+    static void warning(string_view message) { write(LogLevel::Warning, message); }
+    static void info(string_view message) { write(LogLevel::Info, message); }
+    static void debug(string_view message) { write(LogLevel::Debug, message); }
+};
 
-                cout << "\tEnter description : " << endl;
-                getline(cin, desc);
-                if (validateInput(desc) == false)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid description. Description cannot be empty and must have between 2 and 200 characters.");
-                }
-                executed = true;
-            }
-            catch (const invalid_argument &e)
-            {
-                desc = "";
-                number = 0;
-                ifError(e);
-            }
-        }
-    }
+template <typename T>
+struct TaskResult
+{
+    optional<T> value;
 
-    string extractInfo() override
+    void return_value(T result)
     {
-        if (desc.empty() && number == 0)
-        {
-            return "Title and subtitle are empty.";
-        }
-        return to_string(number);
+        value = move(result);
     }
-
-    void displayProgress() override
+    T take()
     {
-        if (desc.empty() && number == 0)
-        {
-            return;
-        }
-        time_t now = time(nullptr);
-        cout << "NumberInputStep completed with input number: " << number << " and input description: " << desc << endl;
-        cout << "Number of error screens displayed: " << errors << endl;
-        cout << "Completion time: " << asctime(localtime(&now)) << endl;
+        return move(*value);
     }
 };
 
-class CalculusStep : public FlowStep
+template <>
+struct TaskResult<void>
 {
-private:
-    NumberInputStep number1{"First Number Input Step", "Description for first number"};
-    NumberInputStep number2{"Second Number Input Step", "Description for second number"};
-    string operation;
-    float result = 0.0f;
+    void return_void() {}
+    void take() {}
+};
 
+// Corutina unui pas (sau a unei rulari). Porneste abia cand e asteptata cu co_await sau pornita cu start(),
+// iar la sfarsit continua direct corutina care o astepta. Cat e suspendata (asteapta un raspuns) nu tine
+// niciun fir: starea ei este doar cadrul corutinei.
+template <typename T = void>
+class Task
+{
 public:
-    CalculusStep(string name, string description) : FlowStep(name, description) {}
-
-    void execute() override
+    struct promise_type : TaskResult<T>
     {
-        displayDetails();
-        if (Skip())
+        coroutine_handle<> continuation = noop_coroutine();
+        exception_ptr error;
+
+        Task get_return_object()
         {
-            return;
+            return Task(coroutine_handle<promise_type>::from_promise(*this));
         }
-        else
+        suspend_always initial_suspend() noexcept { return {}; }
+
+        struct Final
         {
-            try
+            bool await_ready() noexcept { return false; }
+            coroutine_handle<> await_suspend(coroutine_handle<promise_type> done) noexcept
             {
-                cout << "First number: " << endl;
-                number1.execute();
-                cout << "Second number: " << endl;
-                number2.execute();
+                return done.promise().continuation;
+            }
+            void await_resume() noexcept {}
+        };
+        Final final_suspend() noexcept { return {}; }
 
-                cout << "Enter operation (+, -, *, /, min, max): ";
-                cin >> operation;
+        void unhandled_exception()
+        {
+            error = current_exception();
+        }
+    };
 
-                if (operation == "+")
-                {
-                    result = number1.getNumber() + number2.getNumber();
-                }
-                else if (operation == "-")
-                {
-                    result = number1.getNumber() - number2.getNumber();
-                }
-                else if (operation == "*")
-                {
-                    result = number1.getNumber() * number2.getNumber();
-                }
-                else if (operation == "/")
-                {
-                    if (number2.getNumber() != 0)
-                    {
-                        result = number1.getNumber() / number2.getNumber();
-                    }
-                    else
-                    {
-                        errors++;
-                        throw invalid_argument("Division by zero is not allowed.");
-                    }
-                }
-                else if (operation == "min")
-                {
-                    result = min(number1.getNumber(), number2.getNumber());
-                }
-                else if (operation == "max")
-                {
-                    result = max(number1.getNumber(), number2.getNumber());
-                }
-                else
-                {
-                    errors++;
-                    throw invalid_argument("Invalid operation.");
-                }
-                cout << "Result of operation: " << result << endl;
-                cin.ignore();
-            }
-            catch (const invalid_argument &e)
-            {
-                result = 0.0f;
-                number1.setNumber(0);
-                number2.setNumber(0);
-                number1.setDescription("");
-                number2.setDescription("");
-                ifError(e);
-            }
-        }
-    }
+private:
+    coroutine_handle<promise_type> handle;
 
-    string extractInfo() override
+    explicit Task(coroutine_handle<promise_type> Handle) : handle(Handle) {}
+
+public:
+    Task(Task &&other) noexcept : handle(exchange(other.handle, nullptr)) {}
+    Task &operator=(Task &&other) noexcept
     {
-        if (result == 0.0f)
+        if (this != &other)
         {
-            return "Result is empty.";
+            if (handle)
+                handle.destroy();
+            handle = exchange(other.handle, nullptr);
         }
-        return "Number1 = " + to_string(number1.getNumber()) + ", Number2 = " + to_string(number2.getNumber()) + ", Operation = " + operation + ", Result = " + to_string(result);
+        return *this;
     }
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
 
-    void displayProgress() override
+    ~Task()
     {
-        if (result == 0.0f)
-        {
-            return;
-        }
-        time_t now = time(nullptr);
-        cout << "Calculus Step is completed." << endl;
-        cout << "Number of error screens displayed: " << errors << endl;
-        cout << "Completion time: " << asctime(localtime(&now)) << endl;
+        if (handle)
+            handle.destroy();
     }
-};
-
-class TextFileInputStep : public FlowStep
-{
-private:
-    string fileDescription, fileName;
 
-public:
-    TextFileInputStep(string name, string description) : FlowStep(name, description) {}
-
-    string getFileName()
+    bool await_ready() const noexcept { return false; }
+    coroutine_handle<> await_suspend(coroutine_handle<> waiting) noexcept
     {
-        return fileName;
+        handle.promise().continuation = waiting;
+        return handle;
     }
-
-    bool validateInput(string fName) override
+    T await_resume()
     {
-        if (fName.substr(fName.find_last_of(".") + 1) == "txt") // fileName.find_last_of(".") determină ultima poziție a caracterului .
-            return true;
-        return false;
+        if (handle.promise().error)
+            rethrow_exception(handle.promise().error);
+        return handle.promise().take();
     }
 
-    void execute() override
+    // Porneste corutina fara ca alta sa o astepte; ruleaza pana la prima suspendare
+    void start()
     {
-        displayDetails();
-        if (Skip())
-        {
-            return;
-        }
-        else
-        {
-            try
-            {
-                cout << "\tEnter file description : " << endl;
-                getline(cin, fileDescription);
-                if (fileDescription == "" || fileDescription.length() < 2 || fileDescription.length() > 500)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid file description. Description cannot be empty.");
-                }
-                cout << "\tEnter file name:  " << endl;
-                getline(cin, fileName);
-                if (validateInput(fileName) == false)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid file name. The file name must contain the .txt extension.");
-                }
-                executed = true;
-            }
-            catch (const invalid_argument &e)
-            {
-                fileName = "";
-                fileDescription = "";
-                ifError(e);
-            }
-        }
+        handle.resume();
     }
-
-    string extractInfo() override
+    bool done() const
     {
-        if (fileName.empty() && fileDescription.empty())
-        {
-            return "File name and file description are empty.";
-        }
-        return "Description = " + fileDescription + ", File Name = " + fileName;
+        return handle.done();
     }
 
-    void displayProgress() override
+    // Ruleaza corutina pe firul curent pana la capat. Sursele sincrone (consola, raspunsuri scriptate)
+    // au mereu raspunsul, deci nu o suspenda niciodata.
+    T get()
     {
-        if (fileName.empty() && fileDescription.empty())
-        {
-            return;
-        }
-        time_t now = time(nullptr);
-        cout << "Text file input step completed." << endl;
-        cout << "Number of error screens displayed: " << errors << endl;
-        cout << "Completion time: " << asctime(localtime(&now)) << endl;
+        start();
+        if (!done())
+            throw logic_error("A step waited for input outside an event loop.");
+        return await_resume();
     }
 };
 
-class CsvFileInputStep : public FlowStep
+// Un singur fir care ruleaza corutinele multor sesiuni. Alte fire (lucrarile pasilor, cine primeste
+// raspunsurile) trimit aici ce trebuie rulat cu post(); actiunile ruleaza in ordinea in care au sosit.
+class EventLoop
 {
 private:
-    string fileDescription, fileName;
+    mutex lock;
+    condition_variable ready;
+    deque<function<void()>> actions;
+    bool stopping = false;
 
 public:
-    CsvFileInputStep(string name, string description) : FlowStep(name, description) {}
-
-    string getFileName()
+    // Anuntul se da cu lock luat: dupa ultima actiune bucla (si obiectul) se pot termina imediat
+    void post(function<void()> action)
     {
-        return fileName;
+        lock_guard<mutex> guard(lock);
+        actions.push_back(move(action));
+        ready.notify_one();
     }
 
-    bool validateInput(string fName) override
+    void resume(coroutine_handle<> waiting)
     {
-        if (fName.substr(fName.find_last_of(".") + 1) == "csv") // fileName.find_last_of(".") determină ultima poziție a caracterului .
-            return true;
-        return false;
+        post([waiting]
+             { waiting.resume(); });
     }
 
-    void execute() override
+    // Ruleaza actiunile pana la stop(); cele trimise inainte de stop() sunt rulate toate
+    void run()
     {
-        displayDetails();
-        if (Skip())
-        {
-            return;
-        }
-        else
+        deque<function<void()>> batch;
+        while (true)
         {
-            try
-            {
-                cout << "\tEnter file description : " << endl;
-                getline(cin, fileDescription);
-                if (fileDescription == "" || fileDescription.length() < 2 || fileDescription.length() > 500)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid file description. Description cannot be empty.");
-                }
-                cout << "\tEnter file name:  " << endl;
-                getline(cin, fileName);
-                if (validateInput(fileName) == false)
-                {
-                    errors++;
-                    throw invalid_argument("Invalid file name. The file name must contain the .csv extension.");
-                }
-                executed = true;
-            }
-            catch (const invalid_argument &e)
             {
-                fileDescription = "";
-                fileName = "";
-                ifError(e);
+                unique_lock<mutex> guard(lock);
+                ready.wait(guard, [this]
+                           { return stopping || !actions.empty(); });
+                if (actions.empty())
+                    return;
+                swap(batch, actions);
             }
+            for (auto &action : batch)
+                action();
+            batch.clear();
         }
     }
 
-    string extractInfo() override
+    void stop()
     {
-        if (fileName.empty() && fileDescription.empty())
-        {
-            return "File name and file description are empty.";
-        }
-        return "Description = " + fileDescription + ", File Name = " + fileName;
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+        ready.notify_one();
     }
+};
+
+// Sursa raspunsurilor pentru pasi: consola sau un set de raspunsuri scrise dinainte
+class InputSource
+{
+public:
+    virtual bool readLine(string &line) = 0;
+    virtual bool readToken(string &token) = 0;
+    virtual void ignore() {}
+
+    // Sursele sincrone au mereu raspunsul (il asteapta ele); o sesiune il poate primi mai tarziu,
+    // iar corutina care intreaba e reluata cand soseste
+    virtual bool ready() { return true; }
+    virtual void wait(coroutine_handle<>) {}
+
+    virtual ~InputSource() = default;
+};
 
-    void displayProgress() override
+// Inainte de fiecare citire intrebarea trebuie sa fie deja pe ecran (consola scrie asincron)
+class ConsoleInput : public InputSource
+{
+public:
+    bool readLine(string &line) override
     {
-        if (fileName.empty() && fileDescription.empty())
-        {
-            return;
-        }
-        time_t now = time(nullptr);
-        cout << "Csv file input step completed." << endl;
-        cout << "Number of error screens displayed: " << errors << endl;
-        cout << "Completion time: " << asctime(localtime(&now)) << endl;
+        AsyncSink::console().flush();
+        return static_cast<bool>(getline(cin, line));
+    }
+    bool readToken(string &token) override
+    {
+        AsyncSink::console().flush();
+        return static_cast<bool>(cin >> token);
+    }
+    void ignore() override
+    {
+        AsyncSink::console().flush();
+        cin.ignore();
     }
 };
 
-class DisplaySteps : public FlowStep
+// Raspunsurile unei rulari fara utilizator, cate unul pe linie
+class ScriptedInput : public InputSource
 {
 private:
-    int step;
-    FlowStep *previousStep;
-    TextFileInputStep *textInputStep;
-    CsvFileInputStep *csvInputStep;
+    vector<string> owned;
+    const vector<string> *answers; // raspunsurile nu sunt copiate cand vin dintr-un record care traieste mai mult
+    size_t next = 0;
 
 public:
-    DisplaySteps(string name, string description, TextFileInputStep *TextInputStep, CsvFileInputStep *CsvInputStep) : FlowStep(name, description), textInputStep(TextInputStep), csvInputStep(CsvInputStep) {}
+    ScriptedInput(vector<string> Answers) : owned(move(Answers)), answers(&owned) {}
+    ScriptedInput(const vector<string> *Answers) : answers(Answers) {}
 
-    void selectPreviousStep()
+    bool readLine(string &line) override
     {
-        cout << "Choose file type to read (txt/csv): ";
-        string file_type;
-        cin >> file_type;
-
-        if (file_type == "txt")
-        {
-            if (textInputStep->getSkipped() == false)
-            {
-                previousStep = textInputStep;
-                step = 6;
-            }
-        }
-        else if (file_type == "csv")
-        {
-            if (csvInputStep->getSkipped() == false)
-            {
-                previousStep = csvInputStep;
-                step = 7;
-            }
-        }
-        else
-        {
-            cout << "Invalid file type selected. Try again." << endl;
-            errors++;
-            selectPreviousStep();
-        }
+        if (next >= answers->size())
+            return false;
+        line = (*answers)[next++];
+        return true;
     }
 
-    void execute() override
+    // In modul scriptat fiecare raspuns ocupa o linie intreaga, inclusiv optiunile numerice
+    bool readToken(string &token) override
     {
-        displayDetails();
-        if (Skip())
-        {
-            return;
-        }
-        else
-        {
-            selectPreviousStep();
-
-            if (previousStep != nullptr)
-            {
-                if (step == 6)
-                    readFromTextFile(textInputStep->getFileName());
-                else
-                    readFromCsvFile(csvInputStep->getFileName());
-            }
-            else
-            {
-                cout << "No previous step provided." << endl;
-            }
-        }
+        if (!readLine(token))
+            return false;
+        trim(token);
+        return true;
     }
 
-    void readFromTextFile(string fileName)
+    static void trim(string &token)
     {
-        ifstream file(fileName);
-        string line;
-        if (!file.is_open())
-        {
-            cout << "Error opening the text file " << fileName << endl;
-            errors++;
-            return;
-        }
-        cout << "Content of Text File:" << endl;
-        while (getline(file, line))
-        {
-            cout << line << endl;
-        }
-        file.close();
+        size_t first = token.find_first_not_of(" \t\r");
+        size_t last = token.find_last_not_of(" \t\r");
+        token = first == string::npos ? "" : token.substr(first, last - first + 1);
     }
 
-    void readFromCsvFile(string fileName)
+    size_t remaining() const
     {
-        ifstream file(fileName);
-        string line;
-        if (!file.is_open())
-        {
-            cout << "Error opening the csv file " << fileName << endl;
-            errors++;
-            return;
-        }
-        cout << "Content of CSV File:" << endl;
-        while (getline(file, line))
-        {
-            cout << line << endl;
-        }
-        file.close();
+        return answers->size() - next;
     }
 
-    string extractInfo() override
+    // Aceleasi raspunsuri, de la inceput (benchmark-ul repeta un pas cu acelasi script)
+    void rewind()
     {
-        TextFileInputStep *textFileStep = dynamic_cast<TextFileInputStep *>(previousStep);
-        CsvFileInputStep *csvFileStep = dynamic_cast<CsvFileInputStep *>(previousStep);
-        string fileName;
-        if (step == 6)
-        {
-            fileName = textFileStep->getFileName();
-        }
-        else
-        {
-            fileName = csvFileStep->getFileName();
-        }
-
-        ifstream file(fileName);
-        if (!file.is_open())
-        {
-            cout << "Error opening the text file " << fileName << endl;
-            errors++;
-            return "";
-        }
-        // Utilizarea stringstream pentru a citi întregul conținut
-        stringstream buffer;
-        buffer << file.rdbuf();
-        string content = buffer.str();
-        file.close();
-        return content;
+        next = 0;
     }
 
-    void displayProgress() override
+    // Fisierul de raspunsuri: un raspuns pe linie, rularile sunt separate de o linie "---"
+    static vector<vector<string>> loadRecords(const string &fileName)
     {
-        if (previousStep != nullptr)
+        vector<vector<string>> records;
+        ifstream file(fileName);
+        if (!file.is_open())
+            return records;
+        vector<string> record;
+        string line;
+        while (getline(file, line))
         {
-            time_t now = time(nullptr);
-            cout << "Display step completed." << endl;
-            cout << "Number of error screens displayed: " << errors << endl;
-            cout << "Completion time: " << asctime(localtime(&now)) << endl;
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line == "---")
+            {
+                if (!record.empty())
+                    records.push_back(move(record));
+                record.clear();
+            }
+            else
+                record.push_back(line);
         }
+        if (!record.empty())
+            records.push_back(move(record));
+        return records;
     }
 };
 
-class OutputStep : public FlowStep
+// Raspunsurile unei sesiuni (FlowSessions), primite pe firul buclei de evenimente. O intrebare fara raspuns
+// inca suspenda corutina pasului pana la urmatorul deliver; dupa close() raspunsurile lipsa opresc rularea.
+class SessionInput : public InputSource
 {
 private:
-    string nameOfFile;
-    string title;
-    string desc;
-    int step;
-
-public:
-    OutputStep(string name, string description) : FlowStep(name, description) {}
+    deque<string> lines;
+    bool closed = false;
+    coroutine_handle<> waiting;
 
-    bool validateInput(string input) override
+    void wake()
     {
-        if (input == "")
-            return false;
-        return true;
+        if (waiting)
+            exchange(waiting, nullptr).resume();
     }
 
-    void execute()
+public:
+    bool readLine(string &line) override
     {
-        try
-        {
-            cout << "\tEnter the Name of the File : " << endl;
-            getline(cin, nameOfFile);
-            if (validateInput(nameOfFile) == false)
-            {
-                errors++;
-                throw invalid_argument("Invalid name of file. Name cannot be empty.");
-            }
-            cout << "\tEnter the Title of the File : " << endl;
-            getline(cin, title);
-            if (validateInput(title) == false || title.length() < 2 || title.length() > 50)
-            {
-                errors++;
-                throw invalid_argument("Invalid title. Title cannot be empty.");
-            }
-            cout << "\tEnter the Description of the File : " << endl;
-            getline(cin, desc);
-            if (validateInput(desc) == false || desc.length() < 5 || desc.length() > 300)
-            {
-                errors++;
-                throw invalid_argument("Invalid description. Description cannot be empty.");
-            }
-        }
-        catch (const invalid_argument &e)
-        {
-            nameOfFile = "";
-            title = "";
-            desc = "";
-            ifError(e);
-        }
+        if (lines.empty())
+            return false;
+        line = move(lines.front());
+        lines.pop_front();
+        return true;
     }
-    void executeStep(vector<FlowStep *> previousSteps)
+    bool readToken(string &token) override
     {
-        displayDetails();
-        if (Skip())
-        {
-            return;
-        }
-        else
-        {
-            execute();
-            selectPreviousStep(previousSteps);
-        }
+        if (!readLine(token))
+            return false;
+        ScriptedInput::trim(token);
+        return true;
     }
 
-    void selectPreviousStep(vector<FlowStep *> previousSteps)
+    bool ready() override
     {
-        string answer;
-        cout << "Do you want to add information from the previous steps to the file? ";
-        cout << "Choose yes / no ";
-        cin >> answer;
-        if (answer == "no")
-            cout << "The generated text file is: " << nameOfFile << " with title: " << title << " and description: " << description << endl;
-        else if (answer == "yes")
-        {
-            cout << "Steps you can choose from: " << endl;
-            int i = 1;
-            for (auto &step : previousSteps)
-            {
-                cout << i << ". " << step->getName() << endl;
-                i++;
-            }
-            cout << "\n\t\t\t Please enter your choice : ";
-            cin >> step;
-            cout << endl;
-            if (step >= 1 && step <= previousSteps.size())
-            {
-                generateOutputFile(previousSteps[step]);
-                selectPreviousStep(previousSteps);
-            }
-            else
-            {
-                cout << "Invalid choice. Please choose from the options above." << endl;
-                errors++;
-                selectPreviousStep(previousSteps);
-            }
-        }
-        else
-        {
-            cout << "Invalid answer. Try again." << endl;
-            errors++;
-            selectPreviousStep(previousSteps);
-        }
+        return !lines.empty() || closed;
     }
-
-    void generateOutputFile(FlowStep *step)
+    void wait(coroutine_handle<> Waiting) override
     {
-        ofstream outputFile(nameOfFile + ".txt", ios::out | ios::app);
-        if (outputFile.is_open())
-        {
-            outputFile << step->extractInfo() << "\n";
-            outputFile.close();
-        }
-        else
-        {
-            errors++;
-            cout << "Error opening output file. " << endl;
-        }
+        waiting = Waiting;
     }
 
-    void displayProgress() override
+    void deliver(string line)
     {
-        time_t now = time(nullptr);
-        cout << "OutputStep completed. File generated." << endl;
-        cout << "File Name: " << nameOfFile << endl;
-        cout << "File Title: " << title << endl;
-        cout << "File Description: " << desc << endl;
-        cout << "Number of error screens displayed: " << errors << endl;
-        cout << "Completion time: " << asctime(localtime(&now)) << endl;
+        lines.push_back(move(line));
+        wake();
     }
-    string extractInfo()
+    void close()
     {
-        return "Description = " + desc + ", File Name = " + nameOfFile + ", Title = " + title;
+        closed = true;
+        wake();
     }
 };
 
-class EndStep : public FlowStep
+class InputExhausted : public runtime_error
 {
 public:
-    EndStep(string name, string description) : FlowStep(name, description) {}
-
-    void execute()
-    {
-        cout << "End of flow" << endl;
-    }
-    void displayProgress() override
-    {
-        time_t now = time(nullptr);
-        cout << "EndStep completed." << endl;
-        cout << "Completion time: " << asctime(localtime(&now)) << endl;
-    }
+    InputExhausted() : runtime_error("No more answers available for this flow.") {}
 };
 
-class FlowBuilder
+// Legatura pasilor cu exteriorul: de unde se citesc raspunsurile si unde se afiseaza mesajele
+class FlowIO
 {
+public:
+    InputSource &in;
+    ostream &out;
+    bool interactive;
+    EventLoop *loop = nullptr; // bucla sesiunii; nullptr: asteptarile blocheaza firul
+
+    // co_await io.line(x): citeste cand raspunsul exista, altfel corutina asteapta sa soseasca
+    template <typename Target>
+    struct Read
+    {
+        FlowIO &io;
+        Target &target;
+        bool token;
+
+        bool await_ready() { return io.in.ready(); }
+        void await_suspend(coroutine_handle<> waiting) { io.in.wait(waiting); }
+        void await_resume()
+        {
+            if constexpr (is_same_v<Target, int>)
+                io.getToken(target);
+            else if (token)
+                io.getToken(target);
+            else
+                io.getLine(target);
+        }
+    };
+
 private:
-    string name;
-    vector<FlowStep *> steps;
-    int timesStarted = 0;
-    int timesCompleted = 0;
-    int NrScreenSkipped = 0;
-    int TotalErrors = 0;
+    string scratch;
 
 public:
-    bool validateInput(string input)
+
+    FlowIO(InputSource &In, ostream &Out, bool Interactive) : in(In), out(Out), interactive(Interactive) {}
+
+    void getLine(string &line)
     {
-        if (input == "")
-            return false;
+        if (!in.readLine(line))
+            throw InputExhausted();
+    }
+    void getToken(string &token)
+    {
+        if (!in.readToken(token))
+            throw InputExhausted();
+    }
+    // Textele pasilor sunt in memoria rularii; linia e citita intr-un buffer refolosit
+    void getLine(pmr::string &line)
+    {
+        getLine(scratch);
+        line = scratch;
+    }
+    void getToken(pmr::string &token)
+    {
+        getToken(scratch);
+        token = scratch;
+    }
+    void getToken(int &value)
+    {
+        string token;
+        getToken(token);
+        try
+        {
+            value = stoi(token);
+        }
+        catch (const exception &)
+        {
+            value = 0; // la fel ca cin >> int pentru un raspuns care nu e numar
+        }
+    }
+    void ignore()
+    {
+        in.ignore();
+    }
+
+    template <typename Target>
+    Read<Target> line(Target &target)
+    {
+        return {*this, target, false};
+    }
+    template <typename Target>
+    Read<Target> token(Target &target)
+    {
+        return {*this, target, true};
+    }
+
+    static FlowIO &console()
+    {
+        static ConsoleInput input;
+        static FlowIO io(input, cout, true);
+        return io;
+    }
+};
+
+// Mod fara utilizator: nu se afiseaza niciun mesaj, raspunsurile vin din ScriptedInput
+class HeadlessIO : public FlowIO
+{
+private:
+    ostream silent{nullptr};
+
+public:
+    HeadlessIO(InputSource &In) : FlowIO(In, silent, false) {}
+};
+
+enum class StepKind : uint8_t
+{
+    Title = 1,
+    Text,
+    TextInput,
+    NumberInput,
+    Calculus,
+    TextFile,
+    CsvFile,
+    Display,
+    Output,
+    WordCount,
+    End
+};
+
+const char *stepKindName(StepKind kind)
+{
+    switch (kind)
+    {
+    case StepKind::Title:
+        return "title";
+    case StepKind::Text:
+        return "text";
+    case StepKind::TextInput:
+        return "text_input";
+    case StepKind::NumberInput:
+        return "number_input";
+    case StepKind::Calculus:
+        return "calculus";
+    case StepKind::TextFile:
+        return "text_file";
+    case StepKind::CsvFile:
+        return "csv_file";
+    case StepKind::Display:
+        return "display";
+    case StepKind::Output:
+        return "output";
+    case StepKind::WordCount:
+        return "word_count";
+    case StepKind::End:
+        return "end";
+    }
+    return "unknown";
+}
+
+// Histograma de durate (in nanosecunde) in stilul HDR: 8 compartimente pentru fiecare putere a lui 2,
+// deci o eroare de cel mult 12.5%. Inregistrarea e doar un fetch_add, fara lock.
+class LatencyHistogram
+{
+public:
+    static constexpr size_t Buckets = 496;
+
+private:
+    atomic<uint64_t> counts[Buckets] = {};
+    atomic<uint64_t> total{0}, sumNanos{0};
+
+public:
+    static size_t bucketOf(uint64_t nanos)
+    {
+        if (nanos < 8)
+            return static_cast<size_t>(nanos);
+        unsigned exponent = 63 - static_cast<unsigned>(countl_zero(nanos));
+        return (exponent - 2) * 8 + ((nanos >> (exponent - 3)) & 7);
+    }
+
+    // Prima valoare care nu mai intra in compartiment
+    static uint64_t upperBound(size_t bucket)
+    {
+        if (bucket < 8)
+            return bucket + 1;
+        unsigned exponent = static_cast<unsigned>(bucket / 8 + 2);
+        return (9 + bucket % 8) << (exponent - 3);
+    }
+
+    void record(chrono::nanoseconds duration)
+    {
+        uint64_t nanos = static_cast<uint64_t>(max<int64_t>(duration.count(), 0));
+        counts[bucketOf(nanos)].fetch_add(1, memory_order_relaxed);
+        sumNanos.fetch_add(nanos, memory_order_relaxed);
+        total.fetch_add(1, memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total.load(memory_order_relaxed); }
+    uint64_t sum() const { return sumNanos.load(memory_order_relaxed); }
+    uint64_t bucket(size_t index) const { return counts[index].load(memory_order_relaxed); }
+};
+
+// Contoarele si histogramele aplicatiei; se scriu la cerere in formatul text Prometheus
+class Metrics
+{
+public:
+    enum Phase
+    {
+        Execute, // intrebarile pasului
+        Work,    // lucrarea lui (StepGraph)
+        Phases
+    };
+    enum Io
+    {
+        CsvRead,
+        TextRead,
+        OutputWritten,
+        IoCounters
+    };
+
+    struct FlowCounters
+    {
+        atomic<uint64_t> started{0}, completed{0}, errors{0}, skipped{0};
+    };
+
+private:
+    static constexpr size_t Kinds = static_cast<size_t>(StepKind::End) + 1;
+    LatencyHistogram latency[Kinds][Phases];
+    atomic<uint64_t> io[IoCounters] = {};
+    mutex flowsLock;
+    unordered_map<string, unique_ptr<FlowCounters>> flows;
+
+    static string label(string_view value)
+    {
+        string escaped;
+        for (char c : value)
+        {
+            if (c == '\\' || c == '"')
+                escaped += '\\';
+            if (c == '\n')
+                escaped += "\\n";
+            else
+                escaped += c;
+        }
+        return escaped;
+    }
+
+public:
+    static Metrics &shared()
+    {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    void recordStep(StepKind kind, Phase phase, chrono::nanoseconds duration)
+    {
+        latency[static_cast<size_t>(kind)][phase].record(duration);
+    }
+
+    void addBytes(Io counter, uint64_t bytes)
+    {
+        io[counter].fetch_add(bytes, memory_order_relaxed);
+    }
+
+    // Contoarele unui flow raman la aceeasi adresa, deci pot fi pastrate de rulare
+    FlowCounters &flow(const string &name)
+    {
+        lock_guard<mutex> guard(flowsLock);
+        auto &counters = flows[name];
+        if (!counters)
+            counters = make_unique<FlowCounters>();
+        return *counters;
+    }
+
+    void write(ostream &out)
+    {
+        static constexpr double limits[] = {0.000001, 0.00001, 0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 60};
+        static constexpr const char *phaseNames[] = {"execute", "work"};
+        out << "# HELP flow_step_duration_seconds Time spent in a step, by step type and phase.\n";
+        out << "# TYPE flow_step_duration_seconds histogram\n";
+        for (size_t kind = 1; kind < Kinds; kind++)
+        {
+            for (int phase = 0; phase < Phases; phase++)
+            {
+                const LatencyHistogram &histogram = latency[kind][phase];
+                if (histogram.count() == 0)
+                    continue;
+                string labels = string("step=\"") + stepKindName(static_cast<StepKind>(kind)) + "\",phase=\"" + phaseNames[phase] + "\"";
+                uint64_t cumulative = 0;
+                size_t bucket = 0;
+                for (double limit : limits)
+                {
+                    uint64_t nanos = static_cast<uint64_t>(limit * 1e9);
+                    for (; bucket < LatencyHistogram::Buckets && LatencyHistogram::upperBound(bucket) <= nanos + 1; bucket++)
+                        cumulative += histogram.bucket(bucket);
+                    out << "flow_step_duration_seconds_bucket{" << labels << ",le=\"" << limit << "\"} " << cumulative << "\n";
+                }
+                out << "flow_step_duration_seconds_bucket{" << labels << ",le=\"+Inf\"} " << histogram.count() << "\n";
+                out << "flow_step_duration_seconds_sum{" << labels << "} " << histogram.sum() / 1e9 << "\n";
+                out << "flow_step_duration_seconds_count{" << labels << "} " << histogram.count() << "\n";
+            }
+        }
+
+        auto counter = [&](const char *name, const char *help, auto value)
+        {
+            out << "# HELP " << name << " " << help << "\n# TYPE " << name << " counter\n";
+            lock_guard<mutex> guard(flowsLock);
+            for (auto &[flowName, counters] : flows)
+                out << name << "{flow=\"" << label(flowName) << "\"} " << value(*counters) << "\n";
+        };
+        counter("flow_runs_started_total", "Runs started, by flow.", [](FlowCounters &c)
+                { return c.started.load(); });
+        counter("flow_runs_completed_total", "Runs that reached the end step, by flow.", [](FlowCounters &c)
+                { return c.completed.load(); });
+        counter("flow_step_errors_total", "Error screens shown in completed runs, by flow.", [](FlowCounters &c)
+                { return c.errors.load(); });
+        counter("flow_steps_skipped_total", "Steps skipped in completed runs, by flow.", [](FlowCounters &c)
+                { return c.skipped.load(); });
+
+        out << "# HELP flow_file_read_bytes_total Bytes read from input files.\n# TYPE flow_file_read_bytes_total counter\n";
+        out << "flow_file_read_bytes_total{source=\"csv\"} " << io[CsvRead].load() << "\n";
+        out << "flow_file_read_bytes_total{source=\"text\"} " << io[TextRead].load() << "\n";
+        out << "# HELP flow_output_written_bytes_total Bytes written to output files.\n# TYPE flow_output_written_bytes_total counter\n";
+        out << "flow_output_written_bytes_total " << io[OutputWritten].load() << "\n";
+    }
+
+    // Fisierul e inlocuit dintr-o data (fisier temporar + rename), ca cine il citeste sa nu vada o scriere pe jumatate
+    bool writeFile(const string &fileName)
+    {
+        string temporary = fileName + ".tmp";
+        {
+            ofstream file(temporary, ios::out | ios::trunc);
+            if (!file.is_open())
+                return false;
+            write(file);
+            if (!file)
+                return false;
+        }
+#ifdef _WIN32
+        remove(fileName.c_str());
+#endif
+        return rename(temporary.c_str(), fileName.c_str()) == 0;
+    }
+};
+
+// Codificarea binara a snapshot-ului: intregi de latime fixa (ordinea octetilor a masinii), string = lungime + octeti
+class SnapshotWriter
+{
+private:
+    string buffer;
+
+public:
+    void putU8(uint8_t value) { buffer.push_back(static_cast<char>(value)); }
+    void putU32(uint32_t value) { buffer.append(reinterpret_cast<const char *>(&value), sizeof(value)); }
+    void putU64(uint64_t value) { buffer.append(reinterpret_cast<const char *>(&value), sizeof(value)); }
+    void putI32(int32_t value) { putU32(static_cast<uint32_t>(value)); }
+    void putBool(bool value) { putU8(value ? 1 : 0); }
+    void putFloat(float value) { buffer.append(reinterpret_cast<const char *>(&value), sizeof(value)); }
+    void putString(string_view value)
+    {
+        putU32(static_cast<uint32_t>(value.size()));
+        buffer.append(value);
+    }
+    void putBytes(string_view bytes) { buffer.append(bytes.data(), bytes.size()); }
+
+    size_t size() const { return buffer.size(); }
+    const string &data() const { return buffer; }
+    void patchU64(size_t offset, uint64_t value) { memcpy(&buffer[offset], &value, sizeof(value)); }
+};
+
+class SnapshotReader
+{
+private:
+    const char *bytes;
+    size_t length;
+    size_t pos = 0;
+
+    const char *take(size_t count)
+    {
+        if (count > length - pos)
+            throw runtime_error("Corrupt flow snapshot.");
+        const char *start = bytes + pos;
+        pos += count;
+        return start;
+    }
+    template <typename T>
+    T get()
+    {
+        T value;
+        memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+public:
+    SnapshotReader(string_view data) : bytes(data.data()), length(data.size()) {}
+
+    uint8_t getU8() { return get<uint8_t>(); }
+    uint32_t getU32() { return get<uint32_t>(); }
+    uint64_t getU64() { return get<uint64_t>(); }
+    int32_t getI32() { return get<int32_t>(); }
+    bool getBool() { return get<uint8_t>() != 0; }
+    float getFloat() { return get<float>(); }
+    string getString()
+    {
+        uint32_t size = getU32();
+        return string(take(size), size);
+    }
+};
+
+// Fisier mapat in memorie doar pentru citire; pe Windows se citeste tot in buffer
+class MappedFile
+{
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    vector<char> buffer;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const string &fileName)
+    {
+        close();
+#ifdef _WIN32
+        ifstream file(fileName, ios::binary);
+        if (!file.is_open())
+            return false;
+        buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        bytes = buffer.data();
+        length = buffer.size();
+        return true;
+#else
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0)
+        {
+            void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED)
+            {
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            bytes = static_cast<const char *>(mapped);
+        }
+        ::close(fd);
+        return true;
+#endif
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        buffer.clear();
+#else
+        if (bytes != nullptr)
+            munmap(const_cast<char *>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    string_view data() const
+    {
+        return string_view(bytes, length);
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+};
+
+// Numar fix de fire care preiau sarcinile dintr-o coada comuna
+class WorkerPool
+{
+private:
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex lock;
+    condition_variable ready;
+    bool stopping = false;
+
+    void work()
+    {
+        while (true)
+        {
+            function<void()> task;
+            {
+                unique_lock<mutex> guard(lock);
+                ready.wait(guard, [this]
+                           { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                task = move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit WorkerPool(size_t count)
+    {
+        for (size_t i = 0; i < max<size_t>(count, 1); i++)
+            workers.emplace_back(&WorkerPool::work, this);
+    }
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    template <typename Task>
+    auto submit(Task task) -> future<decltype(task())>
+    {
+        auto packaged = make_shared<packaged_task<decltype(task())()>>(move(task));
+        future<decltype(task())> result = packaged->get_future();
+        {
+            lock_guard<mutex> guard(lock);
+            tasks.push([packaged]
+                       { (*packaged)(); });
+        }
+        ready.notify_one();
+        return result;
+    }
+
+    // Fara rezultat de asteptat: nu mai e nevoie de packaged_task si future
+    void post(function<void()> task)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            tasks.push(move(task));
+        }
+        ready.notify_one();
+    }
+
+    size_t size() const
+    {
+        return workers.size();
+    }
+
+    // Sarcinile deja trimise sunt terminate inainte ca firele sa se opreasca
+    ~WorkerPool()
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+};
+
+#ifndef _WIN32
+// Citiri si scrieri la pozitii date, trimise fara ca firul care le cere sa astepte fiecare cerere.
+// Cu io_uring (Linux) un lot de cereri pleaca intr-un singur apel de sistem, iar cele facute in bufferele
+// inregistrate la kernel nu mai sunt mapate la fiecare cerere; un fir culege rezultatele pentru toate
+// flow-urile. Unde io_uring lipseste (sau cu --io threads) pread/pwrite ruleaza pe un pool de fire.
+class AsyncIO
+{
+public:
+    enum class Backend : uint8_t
+    {
+        Threads,
+        Uring
+    };
+
+    static constexpr size_t BufferSize = 256 << 10;
+    static constexpr size_t Buffers = 64; // comune tuturor flow-urilor
+
+    struct Request
+    {
+        int fd;
+        char *data;
+        size_t length;
+        uint64_t offset;
+        bool write = false;
+        int buffer = -1; // bufferul inregistrat in care se afla data, -1 = memorie obisnuita
+    };
+
+    struct Buffer
+    {
+        char *data = nullptr;
+        int index = -1; // -1: alocat separat, cand toate bufferele comune sunt folosite
+    };
+
+private:
+    Backend kind = Backend::Threads;
+    unique_ptr<char[]> storage;
+    vector<int> freeBuffers;
+    mutex bufferLock;
+    unique_ptr<WorkerPool> pool;
+
+    static inline Backend preferred = Backend::Uring;
+
+#ifdef FLOW_IO_URING
+    struct Pending
+    {
+        promise<int64_t> result;
+        iovec part;
+    };
+
+    int ring = -1;
+    void *sqMap = nullptr, *cqMap = nullptr;
+    size_t sqBytes = 0, cqBytes = 0;
+    io_uring_sqe *sqes = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    unsigned *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    unsigned entries = 0, inflight = 0;
+    bool registered = false, stopping = false;
+    mutex submitLock;
+    condition_variable roomFree;
+    thread reaper;
+
+    static int enter(int ring, unsigned submit, unsigned wait, unsigned flags)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring, submit, wait, flags, nullptr, 0));
+    }
+
+    bool setupUring()
+    {
+        io_uring_params params{};
+        ring = static_cast<int>(syscall(__NR_io_uring_setup, 256, &params));
+        if (ring < 0)
+            return false;
+        sqBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single)
+            sqBytes = cqBytes = max(sqBytes, cqBytes);
+        sqMap = mmap(nullptr, sqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+        cqMap = single ? sqMap : mmap(nullptr, cqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+        void *sqeMap = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+        if (sqMap == MAP_FAILED || cqMap == MAP_FAILED || sqeMap == MAP_FAILED)
+        {
+            if (sqeMap != MAP_FAILED)
+                munmap(sqeMap, params.sq_entries * sizeof(io_uring_sqe));
+            closeUring();
+            return false;
+        }
+        char *sq = static_cast<char *>(sqMap), *cq = static_cast<char *>(cqMap);
+        sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        sqes = static_cast<io_uring_sqe *>(sqeMap);
+        entries = params.sq_entries; // coada de rezultate are 2 * entries locuri, deci nu se umple
+
+        // Fara memorie blocata suficienta (RLIMIT_MEMLOCK) bufferele raman obisnuite
+        vector<iovec> regions(Buffers);
+        for (size_t i = 0; i < Buffers; i++)
+            regions[i] = {storage.get() + i * BufferSize, BufferSize};
+        registered = syscall(__NR_io_uring_register, ring, IORING_REGISTER_BUFFERS, regions.data(), static_cast<unsigned>(Buffers)) == 0;
+        reaper = thread(&AsyncIO::reap, this);
+        return true;
+    }
+
+    void closeUring()
+    {
+        if (sqes != nullptr)
+            munmap(sqes, entries * sizeof(io_uring_sqe));
+        if (cqMap != nullptr && cqMap != MAP_FAILED && cqMap != sqMap)
+            munmap(cqMap, cqBytes);
+        if (sqMap != nullptr && sqMap != MAP_FAILED)
+            munmap(sqMap, sqBytes);
+        ::close(ring);
+        ring = -1;
+    }
+
+    // Se apeleaza cu submitLock luat; cererile asteapta cat timp sunt deja entries cereri in lucru
+    void push(unique_lock<mutex> &guard, const Request *requests, size_t count, Pending **pending)
+    {
+        size_t done = 0;
+        while (done < count)
+        {
+            roomFree.wait(guard, [this]
+                          { return inflight < entries; });
+            unsigned tail = *sqTail, batch = 0;
+            for (; done < count && inflight < entries; done++, batch++, inflight++)
+            {
+                const Request &request = requests[done];
+                unsigned index = tail++ & *sqMask;
+                io_uring_sqe &sqe = sqes[index];
+                memset(&sqe, 0, sizeof(sqe));
+                sqe.fd = request.fd;
+                sqe.off = request.offset;
+                sqe.user_data = reinterpret_cast<uint64_t>(pending[done]);
+                if (pending[done] == nullptr)
+                    sqe.opcode = IORING_OP_NOP;
+                else if (registered && request.buffer >= 0)
+                {
+                    sqe.opcode = request.write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+                    sqe.addr = reinterpret_cast<uint64_t>(request.data);
+                    sqe.len = static_cast<unsigned>(request.length);
+                    sqe.buf_index = static_cast<uint16_t>(request.buffer);
+                }
+                else
+                {
+                    pending[done]->part = {request.data, request.length};
+                    sqe.opcode = request.write ? IORING_OP_WRITEV : IORING_OP_READV;
+                    sqe.addr = reinterpret_cast<uint64_t>(&pending[done]->part);
+                    sqe.len = 1;
+                }
+                sqArray[index] = index;
+            }
+            atomic_ref<unsigned>(*sqTail).store(tail, memory_order_release);
+            unsigned sent = 0;
+            while (sent < batch)
+            {
+                int accepted = enter(ring, batch - sent, 0, 0);
+                if (accepted > 0)
+                    sent += static_cast<unsigned>(accepted);
+                else if (accepted == 0 || (errno != EINTR && errno != EAGAIN && errno != EBUSY))
+                {
+                    Log::error("io_uring_enter failed: " + string(accepted == 0 ? "no request accepted" : strerror(errno)));
+                    break;
+                }
+            }
+            if (sent < batch)
+                withdraw(requests, pending, done, batch - sent);
+        }
+    }
+
+    // Ultimele unsent cereri din coada nu au ajuns la kernel: sunt scoase din coada si facute cu pread/pwrite
+    void withdraw(const Request *requests, Pending **pending, size_t done, unsigned unsent)
+    {
+        atomic_ref<unsigned>(*sqTail).store(*sqTail - unsent, memory_order_release);
+        inflight -= unsent;
+        for (size_t i = done - unsent; i < done; i++)
+        {
+            if (pending[i] == nullptr)
+                continue;
+            pending[i]->result.set_value(transfer(requests[i]));
+            delete pending[i];
+        }
+        roomFree.notify_all();
+    }
+
+    // Firul care culege rezultatele tuturor cererilor
+    void reap()
+    {
+        while (true)
+        {
+            unsigned head = *cqHead, tail = atomic_ref<unsigned>(*cqTail).load(memory_order_acquire);
+            if (head == tail)
+            {
+                {
+                    lock_guard<mutex> guard(submitLock);
+                    if (stopping && inflight == 0)
+                        return;
+                }
+                enter(ring, 0, 1, IORING_ENTER_GETEVENTS);
+                continue;
+            }
+            unsigned completed = tail - head;
+            for (; head != tail; head++)
+            {
+                io_uring_cqe &cqe = cqes[head & *cqMask];
+                if (Pending *pending = reinterpret_cast<Pending *>(cqe.user_data))
+                {
+                    pending->result.set_value(cqe.res);
+                    delete pending;
+                }
+            }
+            atomic_ref<unsigned>(*cqHead).store(head, memory_order_release);
+            {
+                lock_guard<mutex> guard(submitLock);
+                inflight -= completed;
+            }
+            roomFree.notify_all();
+        }
+    }
+#endif
+
+    // pread/pwrite pana la capat: se opresc doar la sfarsitul fisierului sau la o eroare
+    static int64_t transfer(const Request &request)
+    {
+        size_t done = 0;
+        while (done < request.length)
+        {
+            ssize_t moved = request.write ? ::pwrite(request.fd, request.data + done, request.length - done, static_cast<off_t>(request.offset + done))
+                                          : ::pread(request.fd, request.data + done, request.length - done, static_cast<off_t>(request.offset + done));
+            if (moved < 0 && errno == EINTR)
+                continue;
+            if (moved < 0)
+                return done != 0 ? static_cast<int64_t>(done) : -errno;
+            if (moved == 0)
+                break;
+            done += static_cast<size_t>(moved);
+        }
+        return static_cast<int64_t>(done);
+    }
+
+public:
+    explicit AsyncIO(Backend backend) : storage(new char[Buffers * BufferSize])
+    {
+        for (int i = static_cast<int>(Buffers) - 1; i >= 0; i--)
+            freeBuffers.push_back(i);
+#ifdef FLOW_IO_URING
+        if (backend == Backend::Uring && setupUring())
+        {
+            kind = Backend::Uring;
+            return;
+        }
+        if (backend == Backend::Uring)
+            Log::info("io_uring is not available, file I/O uses a thread pool");
+#endif
+        pool = make_unique<WorkerPool>(max(4u, thread::hardware_concurrency()));
+    }
+    AsyncIO(const AsyncIO &) = delete;
+    AsyncIO &operator=(const AsyncIO &) = delete;
+
+    // Se apeleaza la pornire, inainte de prima citire
+    static void select(Backend backend)
+    {
+        preferred = backend;
+    }
+
+    // Nu se distruge la iesire: scriitorii statici (OutputWriter::writers) isi golesc bufferele prin el
+    // dupa ce obiectele statice construite mai tarziu au fost deja distruse
+    static AsyncIO &shared()
+    {
+        static AsyncIO *io = new AsyncIO(preferred);
+        return *io;
+    }
+
+    Backend backend() const
+    {
+        return kind;
+    }
+
+    const char *name() const
+    {
+        return kind == Backend::Uring ? "uring" : "threads";
+    }
+
+    // Rezultatul fiecarei cereri: octetii transferati (mai putini doar la sfarsitul fisierului) sau -errno.
+    // Memoria cererilor trebuie sa ramana valida pana la rezultat.
+    vector<future<int64_t>> submit(const Request *requests, size_t count)
+    {
+        vector<future<int64_t>> results;
+        results.reserve(count);
+#ifdef FLOW_IO_URING
+        if (kind == Backend::Uring)
+        {
+            vector<Pending *> pending(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                pending[i] = new Pending();
+                results.push_back(pending[i]->result.get_future());
+            }
+            unique_lock<mutex> guard(submitLock);
+            push(guard, requests, count, pending.data());
+            return results;
+        }
+#endif
+        for (size_t i = 0; i < count; i++)
+        {
+            Request request = requests[i];
+            results.push_back(pool->submit([request]
+                                           { return transfer(request); }));
+        }
+        return results;
+    }
+
+    future<int64_t> submit(const Request &request)
+    {
+        return move(submit(&request, 1).front());
+    }
+
+    // Un buffer de BufferSize octeti; cele comune sunt inregistrate la kernel
+    Buffer acquire()
+    {
+        lock_guard<mutex> guard(bufferLock);
+        if (freeBuffers.empty())
+            return {new char[BufferSize], -1};
+        int index = freeBuffers.back();
+        freeBuffers.pop_back();
+        return {storage.get() + index * BufferSize, index};
+    }
+
+    void release(Buffer buffer)
+    {
+        if (buffer.index < 0)
+        {
+            delete[] buffer.data;
+            return;
+        }
+        lock_guard<mutex> guard(bufferLock);
+        freeBuffers.push_back(buffer.index);
+    }
+
+    // Cererile trimise deja sunt terminate inainte de inchidere
+    ~AsyncIO()
+    {
+#ifdef FLOW_IO_URING
+        if (kind == Backend::Uring)
+        {
+            {
+                unique_lock<mutex> guard(submitLock);
+                stopping = true;
+                Pending *none = nullptr;
+                Request wake{-1, nullptr, 0, 0};
+                push(guard, &wake, 1, &none);
+            }
+            reaper.join();
+            closeUring();
+        }
+#endif
+    }
+};
+#endif
+
+// Fisier de intrare citit pe bucati. Un nume terminat in .gz, .zst, .bz2 sau .xz este decomprimat din mers
+// de programul extern (gzip -dc, ...), pornit direct, fara shell, si fara fisier intermediar pe disc. Un fir citeste iesirea lui in bucati
+// cat timp pasul le prelucreaza pe cele deja sosite, deci decomprimarea si prelucrarea merg in paralel.
+// Fisierele necomprimate sunt citite prin AsyncIO: urmatoarele bucati sunt cerute inainte sa fie nevoie de ele.
+class InputFile
+{
+public:
+    static constexpr size_t ChunkSize = 256 << 10;
+    static constexpr size_t Chunks = 4; // bucati decomprimate care asteapta sa fie citite
+
+    struct Codec
+    {
+        string_view suffix;
+        const char *program; // apelat ca "program -dc -- fisier"
+    };
+
+private:
+    static constexpr Codec codecs[] = {{".gz", "gzip"}, {".zst", "zstd"}, {".bz2", "bzip2"}, {".xz", "xz"}};
+
+    ifstream plain;
+    FILE *pipe = nullptr;
+    const Codec *codec = nullptr;
+    string failure;
+    thread reader;
+    mutex lock;
+    condition_variable changed;
+    deque<string> full;
+    vector<string> spare;
+    bool ended = false, stopping = false;
+    string current;
+    size_t offset = 0;
+
+#ifndef _WIN32
+    // O citire trimisa inainte, in bufferul ei
+    struct Ahead
+    {
+        future<int64_t> length;
+        AsyncIO::Buffer buffer;
+        uint64_t start;
+        size_t expected;
+    };
+
+    int fd = -1;
+    pid_t child = -1;
+    uint64_t fileSize = 0, requested = 0;
+    deque<Ahead> ahead;
+    AsyncIO::Buffer chunk;
+    size_t chunkLength = 0;
+
+    // Pana la Chunks citiri in lucru, trimise intr-un singur lot
+    void requestAhead()
+    {
+        vector<AsyncIO::Request> batch;
+        size_t first = ahead.size();
+        while (ahead.size() < Chunks && requested < fileSize)
+        {
+            size_t length = static_cast<size_t>(min<uint64_t>(ChunkSize, fileSize - requested));
+            AsyncIO::Buffer buffer = AsyncIO::shared().acquire();
+            batch.push_back({fd, buffer.data, length, requested, false, buffer.index});
+            ahead.push_back({future<int64_t>(), buffer, requested, length});
+            requested += length;
+        }
+        if (batch.empty())
+            return;
+        auto results = AsyncIO::shared().submit(batch.data(), batch.size());
+        for (size_t i = 0; i < results.size(); i++)
+            ahead[first + i].length = move(results[i]);
+    }
+
+    // Bucata urmatoare devine cea curenta; false la sfarsitul fisierului
+    bool nextChunk()
+    {
+        if (chunk.data != nullptr)
+            AsyncIO::shared().release(chunk);
+        chunk = {};
+        chunkLength = offset = 0;
+        if (ahead.empty())
+            return false;
+        Ahead next = move(ahead.front());
+        ahead.pop_front();
+        int64_t length = next.length.get();
+        if (length < 0)
+            Log::warning("File read failed: " + string(strerror(static_cast<int>(-length))));
+        chunk = next.buffer;
+        chunkLength = length > 0 ? static_cast<size_t>(length) : 0;
+        // citire scurta in mijlocul fisierului: restul se citeste direct
+        if (length >= 0 && chunkLength < next.expected)
+        {
+            AsyncIO::Request rest{fd, chunk.data + chunkLength, next.expected - chunkLength, next.start + chunkLength};
+            while (rest.length != 0)
+            {
+                ssize_t moved = ::pread(fd, rest.data, rest.length, static_cast<off_t>(rest.offset));
+                if (moved < 0 && errno == EINTR)
+                    continue;
+                if (moved <= 0)
+                    break;
+                rest.data += moved;
+                rest.length -= moved;
+                rest.offset += moved;
+                chunkLength += moved;
+            }
+        }
+        if (chunkLength < next.expected)
+        {
+            dropAhead(); // fisierul s-a scurtat sau nu mai poate fi citit
+            return chunkLength != 0;
+        }
+        requestAhead();
+        return true;
+    }
+
+    void dropAhead()
+    {
+        for (auto &pending : ahead)
+        {
+            pending.length.wait();
+            AsyncIO::shared().release(pending.buffer);
+        }
+        ahead.clear();
+        requested = fileSize;
+    }
+#endif
+
+#ifdef _WIN32
+    // _popen trece comanda prin cmd.exe, deci numele e pus intre ghilimele
+    static string quoted(const string &fileName)
+    {
+        return "\"" + fileName + "\"";
+    }
+#else
+    // Programul primeste numele ca argument separat (posix_spawnp), deci nu trece prin /bin/sh
+    bool spawn(const string &fileName)
+    {
+        // ambele capete inchise la exec: un alt program pornit in paralel nu mosteneste capatul de scriere
+        int ends[2];
+        if (::pipe2(ends, O_CLOEXEC) != 0)
+        {
+            failure = "Cannot create a pipe for " + fileName + ": " + strerror(errno);
+            return false;
+        }
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, ends[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addclose(&actions, ends[1]);
+        const char *arguments[] = {codec->program, "-dc", "--", fileName.c_str(), nullptr};
+        int error = posix_spawnp(&child, codec->program, &actions, nullptr, const_cast<char *const *>(arguments), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        ::close(ends[1]);
+        if (error != 0)
+        {
+            ::close(ends[0]);
+            child = -1;
+            failure = error == ENOENT ? string(codec->program) + " is not installed; it is needed to read " + fileName
+                                      : "Cannot start " + string(codec->program) + " for " + fileName + ": " + strerror(error);
+            return false;
+        }
+        pipe = fdopen(ends[0], "r");
+        if (pipe == nullptr)
+        {
+            failure = "Cannot read the output of " + string(codec->program) + ": " + strerror(errno);
+            ::close(ends[0]);
+            while (waitpid(child, nullptr, 0) < 0 && errno == EINTR)
+                ;
+            child = -1;
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    void readLoop()
+    {
+        while (true)
+        {
+            string chunk;
+            {
+                unique_lock<mutex> guard(lock);
+                changed.wait(guard, [this]
+                             { return stopping || full.size() < Chunks; });
+                if (stopping)
+                    return;
+                if (!spare.empty())
+                {
+                    chunk = move(spare.back());
+                    spare.pop_back();
+                }
+            }
+            chunk.resize(ChunkSize);
+            size_t length = fread(chunk.data(), 1, ChunkSize, pipe);
+            chunk.resize(length);
+            {
+                lock_guard<mutex> guard(lock);
+                if (length == 0)
+                    ended = true;
+                else
+                    full.push_back(move(chunk));
+            }
+            changed.notify_all();
+            if (length == 0)
+                return;
+        }
+    }
+
+public:
+    InputFile() = default;
+    InputFile(const InputFile &) = delete;
+    InputFile &operator=(const InputFile &) = delete;
+
+    ~InputFile()
+    {
+        close();
+    }
+
+    static const Codec *codecOf(string_view fileName)
+    {
+        for (auto &candidate : codecs)
+        {
+            if (fileName.size() > candidate.suffix.size() && fileName.substr(fileName.size() - candidate.suffix.size()) == candidate.suffix)
+                return &candidate;
+        }
+        return nullptr;
+    }
+
+    // "date.csv.gz" -> "date.csv"
+    static string_view withoutCodec(string_view fileName)
+    {
+        const Codec *found = codecOf(fileName);
+        return found == nullptr ? fileName : fileName.substr(0, fileName.size() - found->suffix.size());
+    }
+
+    bool open(const string &fileName)
+    {
+        close();
+        failure.clear();
+        codec = codecOf(fileName);
+        if (codec == nullptr)
+        {
+#ifndef _WIN32
+            fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat info;
+            if (fd >= 0 && fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+            {
+                fileSize = static_cast<uint64_t>(info.st_size);
+                requested = 0;
+                requestAhead();
+                return true;
+            }
+            if (fd >= 0)
+                ::close(fd);
+            fd = -1;
+#endif
+            plain.open(fileName, ios::binary);
+            return plain.is_open();
+        }
+        struct stat info;
+        if (stat(fileName.c_str(), &info) != 0)
+            return false;
+#ifdef _WIN32
+        string command = string(codec->program) + " -dc " + quoted(fileName);
+        pipe = _popen(command.c_str(), "rb");
+#else
+        if (!spawn(fileName))
+        {
+            Log::error(failure);
+            return false;
+        }
+#endif
+        if (pipe == nullptr)
+            return false;
+        ended = stopping = false;
+        reader = thread(&InputFile::readLoop, this);
+        return true;
+    }
+
+    // Cel mult size octeti; mai putini doar la sfarsitul fisierului
+    size_t read(char *buffer, size_t size)
+    {
+#ifndef _WIN32
+        if (fd >= 0)
+        {
+            size_t copied = 0;
+            while (copied < size && (offset < chunkLength || nextChunk()))
+            {
+                size_t length = min(size - copied, chunkLength - offset);
+                memcpy(buffer + copied, chunk.data + offset, length);
+                offset += length;
+                copied += length;
+            }
+            return copied;
+        }
+#endif
+        if (pipe == nullptr)
+        {
+            plain.read(buffer, static_cast<streamsize>(size));
+            return static_cast<size_t>(plain.gcount());
+        }
+        size_t copied = 0;
+        while (copied < size)
+        {
+            if (offset == current.size())
+            {
+                {
+                    unique_lock<mutex> guard(lock);
+                    if (!current.empty())
+                        spare.push_back(move(current));
+                    changed.wait(guard, [this]
+                                 { return !full.empty() || ended; });
+                    if (full.empty())
+                    {
+                        current.clear();
+                        offset = 0;
+                        break;
+                    }
+                    current = move(full.front());
+                    full.pop_front();
+                    offset = 0;
+                }
+                changed.notify_all();
+            }
+            size_t length = min(size - copied, current.size() - offset);
+            memcpy(buffer + copied, current.data() + offset, length);
+            offset += length;
+            copied += length;
+        }
+        return copied;
+    }
+
+    // false daca programul de decomprimare a esuat (fisier stricat, program lipsa)
+    bool close()
+    {
+        if (plain.is_open())
+            plain.close();
+#ifndef _WIN32
+        if (fd >= 0)
+        {
+            dropAhead();
+            if (chunk.data != nullptr)
+                AsyncIO::shared().release(chunk);
+            chunk = {};
+            chunkLength = offset = 0;
+            ::close(fd);
+            fd = -1;
+        }
+#endif
+        if (pipe == nullptr)
+            return true;
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        changed.notify_all();
+        reader.join();
+#ifdef _WIN32
+        int status = _pclose(pipe);
+#else
+        fclose(pipe);
+        int status = 0;
+        while (waitpid(child, &status, 0) < 0 && errno == EINTR)
+            ;
+        child = -1;
+#endif
+        pipe = nullptr;
+        bool complete = ended;
+        full.clear();
+        spare.clear();
+        current.clear();
+        offset = 0;
+        // inchis inainte de sfarsit: programul se opreste din cauza pipe-ului inchis, nu e o eroare
+        if (status == 0 || !complete)
+            return true;
+#ifndef _WIN32
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 127) // exec a esuat in procesul copil
+            failure = string(codec->program) + " is not installed or cannot be run";
+        else
+#endif
+            failure = string(codec->program) + " -dc failed";
+        return false;
+    }
+
+    // De ce a esuat ultimul open() sau close(); gol daca nu se stie
+    const string &error() const
+    {
+        return failure;
+    }
+
+    // Tot continutul (decomprimat) al fisierului
+    static bool readAll(const string &fileName, string &content, string &error)
+    {
+        InputFile file;
+        if (!file.open(fileName))
+        {
+            error = file.error().empty() ? "Cannot open " + fileName : file.error();
+            return false;
+        }
+        content.clear();
+#ifndef _WIN32
+        content.reserve(file.fileSize + ChunkSize); // 0 pentru fisierele comprimate
+#endif
+        size_t length = 0;
+        do
+        {
+            content.resize(length + ChunkSize);
+            length += file.read(content.data() + length, ChunkSize);
+        } while (length == content.size());
+        content.resize(length);
+        if (!file.close())
+        {
+            error = "Cannot decompress " + fileName + " (" + file.error() + ")";
+            return false;
+        }
+        return true;
+    }
+};
+
+// Amprenta pe 64 de biti a unor date (parametri, continut de fisiere); doua intrari diferite
+// dau aceeasi amprenta doar intamplator, cu probabilitate neglijabila
+class Fingerprint
+{
+private:
+    uint64_t value = 0x9e3779b97f4a7c15ull;
+
+    static uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+public:
+    Fingerprint &add(uint64_t x)
+    {
+        value = mix(value ^ (x + 0x9e3779b97f4a7c15ull + (value << 6) + (value >> 2)));
+        return *this;
+    }
+
+    // Cate 8 octeti o data; lungimea intra si ea, ca "ab" + "c" sa difere de "a" + "bc"
+    Fingerprint &add(string_view bytes)
+    {
+        uint64_t lanes[4] = {value, value ^ 1, value ^ 2, value ^ 3};
+        size_t i = 0;
+        for (; i + 32 <= bytes.size(); i += 32)
+        {
+            for (int lane = 0; lane < 4; lane++)
+            {
+                uint64_t word;
+                memcpy(&word, bytes.data() + i + lane * 8, 8);
+                lanes[lane] = (lanes[lane] ^ word) * 0x9ddfea08eb382d69ull;
+                lanes[lane] ^= lanes[lane] >> 29;
+            }
+        }
+        for (uint64_t lane : lanes)
+            add(lane);
+        for (; i + 8 <= bytes.size(); i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, bytes.data() + i, 8);
+            add(word);
+        }
+        uint64_t tail = 0;
+        if (i < bytes.size())
+            memcpy(&tail, bytes.data() + i, bytes.size() - i);
+        return add(tail).add(static_cast<uint64_t>(bytes.size()));
+    }
+
+    uint64_t get() const
+    {
+        return value;
+    }
+
+    // Amprenta continutului unui fisier. Daca marimea si data modificarii sunt cele de la ultima citire
+    // se refoloseste amprenta veche; altfel fisierul e citit (mapat) din nou. false daca nu exista.
+    static bool ofFile(const string &fileName, uint64_t &result)
+    {
+        struct stat info;
+        if (stat(fileName.c_str(), &info) != 0)
+            return false;
+        uint64_t size = static_cast<uint64_t>(info.st_size);
+#if defined(__APPLE__)
+        uint64_t modified = info.st_mtimespec.tv_sec * 1000000000ull + info.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+        uint64_t modified = static_cast<uint64_t>(info.st_mtime);
+#else
+        uint64_t modified = info.st_mtim.tv_sec * 1000000000ull + info.st_mtim.tv_nsec;
+#endif
+        struct Seen
+        {
+            uint64_t size, modified, content;
+        };
+        static mutex lock;
+        static unordered_map<string, Seen> seen;
+        {
+            lock_guard<mutex> guard(lock);
+            auto found = seen.find(fileName);
+            if (found != seen.end() && found->second.size == size && found->second.modified == modified)
+            {
+                result = found->second.content;
+                return true;
+            }
+        }
+        MappedFile file;
+        if (!file.open(fileName))
+            return false;
+        result = Fingerprint().add(file.data()).get();
+        lock_guard<mutex> guard(lock);
+        seen[fileName] = {size, modified, result};
+        return true;
+    }
+};
+
+// Mai multe fisiere citite ca unul singur: un director ("data/") sau un tipar pentru numele fisierelor
+// ("data/2026-10-*.csv", cu * si ?). Fisierele sunt luate in ordinea numelui. Cat timp e prelucrat un
+// fisier, urmatoarele (cel mult concurrency()) sunt citite si decomprimate in paralel pe firele unui pool.
+class FileSet
+{
+public:
+    // O bucata din continutul unui fisier din set. Prima bucata a fisierului (starts) contine tot primul rand,
+    // iar ultima se termina cu \n. O bucata cu error e ultima a fisierului ei.
+    struct Chunk
+    {
+        string fileName, content, error;
+        size_t skip = 0; // antetul csv repetat
+        bool starts = false;
+
+        string_view data() const
+        {
+            return string_view(content).substr(skip);
+        }
+    };
+
+private:
+    static constexpr size_t ChunksAhead = 4; // bucati citite inainte, pentru fiecare fisier
+    static inline size_t limit = 0;          // 0: cate fire are masina
+
+    // Un fisier citit pe un fir din pool. Cand are ChunksAhead bucati necitite, sarcina se opreste (parked)
+    // in loc sa tina firul ocupat, si e trimisa din nou cand cititorul ia o bucata.
+    struct Stream
+    {
+        string fileName;
+        InputFile file;
+        mutex lock;
+        condition_variable changed;
+        deque<Chunk> chunks;
+        bool opened = false, started = false, ended = false, parked = false, stopping = false;
+        char last = '\n';
+    };
+
+    static WorkerPool &readers()
+    {
+        static WorkerPool pool(concurrency());
+        return pool;
+    }
+
+    // * = orice sir de caractere, ? = un caracter
+    static bool matches(string_view pattern, string_view name)
+    {
+        size_t p = 0, n = 0, star = string_view::npos, resume = 0;
+        while (n < name.size())
+        {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
+            {
+                p++;
+                n++;
+            }
+            else if (p < pattern.size() && pattern[p] == '*')
+            {
+                star = p++;
+                resume = n;
+            }
+            else if (star != string_view::npos)
+            {
+                p = star + 1;
+                n = ++resume;
+            }
+            else
+                return false;
+        }
+        while (p < pattern.size() && pattern[p] == '*')
+            p++;
+        return p == pattern.size();
+    }
+
+    static size_t lastSeparator(string_view name)
+    {
+#ifdef _WIN32
+        return name.find_last_of("/\\");
+#else
+        return name.find_last_of('/');
+#endif
+    }
+
+    static void finish(Stream &stream, Chunk chunk)
+    {
+        {
+            lock_guard<mutex> guard(stream.lock);
+            if (!chunk.error.empty() || !chunk.content.empty())
+                stream.chunks.push_back(move(chunk));
+            stream.ended = true;
+        }
+        stream.changed.notify_all();
+    }
+
+    static void produce(const shared_ptr<Stream> &shared)
+    {
+        Stream &stream = *shared;
+        if (!stream.opened && !stream.file.open(stream.fileName))
+        {
+            Chunk failed;
+            failed.fileName = stream.fileName;
+            failed.error = stream.file.error().empty() ? "Cannot open " + stream.fileName : stream.file.error();
+            finish(stream, move(failed));
+            return;
+        }
+        stream.opened = true;
+        while (true)
+        {
+            {
+                lock_guard<mutex> guard(stream.lock);
+                if (stream.stopping || stream.chunks.size() >= ChunksAhead)
+                {
+                    stream.parked = !stream.stopping;
+                    return;
+                }
+            }
+            Chunk chunk;
+            chunk.fileName = stream.fileName;
+            chunk.starts = !stream.started;
+            size_t length = 0, moved;
+            do
+            {
+                chunk.content.resize(length + InputFile::ChunkSize);
+                moved = stream.file.read(chunk.content.data() + length, InputFile::ChunkSize);
+                length += moved;
+            } while (moved != 0 && chunk.starts && string_view(chunk.content.data() + length - moved, moved).find('\n') == string_view::npos);
+            chunk.content.resize(length);
+            if (length == 0)
+            {
+                if (!stream.file.close())
+                    chunk.error = "Cannot decompress " + stream.fileName + " (" + stream.file.error() + ")";
+                else if (stream.last != '\n')
+                    chunk.content = "\n";
+                chunk.starts = false;
+                finish(stream, move(chunk));
+                return;
+            }
+            stream.started = true;
+            stream.last = chunk.content.back();
+            {
+                lock_guard<mutex> guard(stream.lock);
+                stream.chunks.push_back(move(chunk));
+            }
+            stream.changed.notify_all();
+        }
+    }
+
+public:
+    // Fisierele, in ordine, ca un singur sir de bucati. Pana la concurrency() fisiere sunt citite in paralel,
+    // fiecare cu cel mult ChunksAhead bucati in asteptare, deci memoria nu depinde de marimea fisierelor.
+    class Reader
+    {
+    private:
+        vector<string> files;
+        size_t submitted = 0;
+        deque<shared_ptr<Stream>> window;
+        bool sharedHeader, first = true;
+        string header;
+
+        void fill()
+        {
+            while (window.size() < concurrency() && submitted < files.size())
+            {
+                auto stream = make_shared<Stream>();
+                stream->fileName = files[submitted++];
+                window.push_back(stream);
+                readers().post([stream]
+                               { produce(stream); });
+            }
+        }
+
+    public:
+        // sharedHeader: fisiere csv cu acelasi antet, pastrat doar la primul fisier
+        Reader(vector<string> Files, bool SharedHeader) : files(move(Files)), sharedHeader(SharedHeader)
+        {
+            fill();
+        }
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        // Fisierele inca in citire se opresc la urmatoarea bucata
+        ~Reader()
+        {
+            for (auto &stream : window)
+            {
+                lock_guard<mutex> guard(stream->lock);
+                stream->stopping = true;
+            }
+        }
+
+        bool next(Chunk &chunk)
+        {
+            while (!window.empty())
+            {
+                shared_ptr<Stream> stream = window.front();
+                bool resume;
+                {
+                    unique_lock<mutex> guard(stream->lock);
+                    stream->changed.wait(guard, [&]
+                                         { return !stream->chunks.empty() || stream->ended; });
+                    if (stream->chunks.empty())
+                    {
+                        guard.unlock();
+                        window.pop_front();
+                        fill();
+                        continue;
+                    }
+                    chunk = move(stream->chunks.front());
+                    stream->chunks.pop_front();
+                    resume = stream->parked;
+                    stream->parked = false;
+                }
+                if (resume)
+                    readers().post([stream]
+                                   { produce(stream); });
+                if (sharedHeader && chunk.starts)
+                {
+                    string_view line = string_view(chunk.content).substr(0, chunk.content.find('\n') + 1);
+                    if (first)
+                        header = line;
+                    else if (line == header)
+                        chunk.skip = line.size();
+                    first = false;
+                }
+                return true;
+            }
+            return false;
+        }
+
+        size_t size() const
+        {
+            return files.size();
+        }
+    };
+
+    // Se apeleaza la pornire, inainte de prima citire
+    static void setConcurrency(size_t count)
+    {
+        limit = count;
+    }
+
+    static size_t concurrency()
+    {
+        return limit != 0 ? limit : max(1u, thread::hardware_concurrency());
+    }
+
+    static bool isPattern(string_view name)
+    {
+        size_t separator = lastSeparator(name);
+        return name.find_first_of("*?", separator == string_view::npos ? 0 : separator + 1) != string_view::npos;
+    }
+
+    static bool isDirectory(const string &name)
+    {
+        error_code failed;
+        return filesystem::is_directory(name, failed);
+    }
+
+    static bool isSet(const string &name)
+    {
+        return isPattern(name) || isDirectory(name);
+    }
+
+    // Fisierele numite de name, in ordinea numelui. Dintr-un director se iau cele cu extensia data
+    // (".txt", eventual comprimate); un nume care nu e set este chiar fisierul cerut.
+    static vector<string> expand(const string &name, string_view extension)
+    {
+        if (!isSet(name))
+            return {name};
+        string prefix, pattern;
+        if (isPattern(name))
+        {
+            size_t separator = lastSeparator(name);
+            prefix = separator == string::npos ? "" : name.substr(0, separator + 1);
+            pattern = name.substr(prefix.size());
+        }
+        else
+        {
+            prefix = name;
+            if (lastSeparator(prefix) + 1 != prefix.size())
+                prefix += '/';
+        }
+        vector<string> files;
+        error_code failed;
+        for (auto &entry : filesystem::directory_iterator(prefix.empty() ? "." : prefix, failed))
+        {
+            if (!entry.is_regular_file(failed))
+                continue;
+            string file = entry.path().filename().string();
+            string_view plainName = InputFile::withoutCodec(file);
+            bool wanted = pattern.empty() ? plainName.size() > extension.size() && plainName.substr(plainName.size() - extension.size()) == extension : matches(pattern, file);
+            if (wanted)
+                files.push_back(prefix + file);
+        }
+        sort(files.begin(), files.end());
+        return files;
+    }
+
+    // Tot continutul setului, ca un singur text (pentru cine are nevoie de el intreg, ca parserul csv);
+    // un fisier care nu poate fi citit opreste citirea
+    static bool readAll(const string &name, string_view extension, bool sharedHeader, string &content, string &error)
+    {
+        if (!isSet(name))
+            return InputFile::readAll(name, content, error);
+        Reader reader(expand(name, extension), sharedHeader);
+        if (reader.size() == 0)
+        {
+            error = "No files match " + name;
+            return false;
+        }
+        content.clear();
+        Chunk chunk;
+        while (reader.next(chunk))
+        {
+            if (!chunk.error.empty())
+            {
+                error = chunk.error;
+                return false;
+            }
+            content += chunk.data();
+        }
+        return true;
+    }
+
+    // Amprenta continutului tuturor fisierelor, calculata in paralel; false daca setul e gol
+    // sau un fisier nu mai exista
+    static bool fingerprint(const string &name, string_view extension, uint64_t &result)
+    {
+        if (!isSet(name))
+            return Fingerprint::ofFile(name, result);
+        vector<string> files = expand(name, extension);
+        vector<future<pair<bool, uint64_t>>> contents;
+        for (auto &file : files)
+            contents.push_back(readers().submit([file]
+                                                {
+                                                    uint64_t content = 0;
+                                                    bool found = Fingerprint::ofFile(file, content);
+                                                    return make_pair(found, content); }));
+        Fingerprint combined;
+        bool complete = !files.empty();
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            auto [found, content] = contents[i].get();
+            complete = complete && found;
+            combined.add(files[i]).add(content);
+        }
+        result = combined.get();
+        return complete;
+    }
+};
+
+// Rezultatele lucrarilor pasilor (tabele csv, coloane calculate), pastrate intre rulari dupa amprenta
+// intrarilor. O rulare noua cu aceleasi intrari reia rezultatul in loc sa refaca lucrarea; cand memoria
+// depaseste limita se elimina rezultatele folosite cel mai de demult.
+class WorkCache
+{
+private:
+    struct Entry
+    {
+        shared_ptr<const void> value;
+        size_t bytes;
+        list<uint64_t>::iterator age;
+    };
+
+    mutex lock;
+    unordered_map<uint64_t, Entry> entries;
+    list<uint64_t> ages; // cel mai recent folosit in fata
+    size_t bytes = 0;
+    size_t limit = 256 << 20;
+    SharedCounter hitCount, missCount;
+
+public:
+    static WorkCache &shared()
+    {
+        static WorkCache cache;
+        return cache;
+    }
+
+    template <typename T>
+    shared_ptr<const T> find(uint64_t key)
+    {
+        lock_guard<mutex> guard(lock);
+        auto found = entries.find(key);
+        if (found == entries.end())
+        {
+            missCount++;
+            return nullptr;
+        }
+        hitCount++;
+        ages.splice(ages.begin(), ages, found->second.age);
+        return static_pointer_cast<const T>(found->second.value);
+    }
+
+    template <typename T>
+    void store(uint64_t key, shared_ptr<const T> value, size_t size)
+    {
+        lock_guard<mutex> guard(lock);
+        if (size > limit || entries.count(key) != 0)
+            return;
+        ages.push_front(key);
+        entries[key] = {move(value), size, ages.begin()};
+        bytes += size;
+        while (bytes > limit)
+        {
+            auto oldest = entries.find(ages.back());
+            bytes -= oldest->second.bytes;
+            entries.erase(oldest);
+            ages.pop_back();
+        }
+    }
+
+    void setLimit(size_t maxBytes)
+    {
+        lock_guard<mutex> guard(lock);
+        limit = maxBytes;
+    }
+
+    int hits() const { return hitCount; }
+    int misses() const { return missCount; }
+};
+
+enum class CsvType : uint8_t
+{
+    Integer,
+    Double,
+    Text
+};
+
+// O coloana dintr-un fisier csv, cu valorile intr-un singur buffer de tipul ei
+struct CsvColumn
+{
+    string name;
+    CsvType type = CsvType::Integer;
+    vector<int64_t> integers;
+    vector<double> numbers; // valorile lipsa sunt NaN
+    string text;            // coloanele text: valorile una dupa alta
+    vector<uint64_t> textEnds;
+
+    size_t size() const
+    {
+        return type == CsvType::Integer ? integers.size() : type == CsvType::Double ? numbers.size() : textEnds.size();
+    }
+
+    string_view textAt(size_t row) const
+    {
+        uint64_t start = row == 0 ? 0 : textEnds[row - 1];
+        return string_view(text).substr(start, textEnds[row] - start);
+    }
+
+    const char *typeName() const
+    {
+        return type == CsvType::Integer ? "integer" : type == CsvType::Double ? "double" : "text";
+    }
+
+    // Valorile coloanei ca double; pentru o coloana text vectorul e gol
+    vector<double> asDoubles() const
+    {
+        if (type == CsvType::Integer)
+            return vector<double>(integers.begin(), integers.end());
+        return numbers;
+    }
+};
+
+// Fisier csv incarcat pe coloane: prima linie contine numele coloanelor, tipul fiecarei coloane
+// este dedus din valori (integer, apoi double, apoi text). Campurile pot fi intre ghilimele, cu "" pentru ".
+class CsvTable
+{
+private:
+    static unsigned lowestBit(uint64_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return index;
+#else
+        return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+    }
+
+    // Campurile din data, intr-o singura trecere. Caracterele speciale (delimitator, ghilimele, \n) sunt cautate
+    // cate 64 de octeti o data si tratate pe loc, fara sa fie pastrate. Primul rand e antetul: header(text, quoted)
+    // pentru fiecare nume. Pentru randurile de date field(coloana, text, quoted, inceputul randului) primeste
+    // campurile din antet, cele lipsa fiind goale, apoi row(malformat). Randurile goale sunt sarite.
+    template <typename Header, typename Field, typename Row>
+    static void scan(string_view data, char delimiter, Header header, Field field, Row row)
+    {
+        bool inQuotes = false, quoted = false, inHeader = true;
+        size_t fieldStart = 0, rowStart = 0, column = 0, columns = 0;
+        auto endField = [&](size_t end, bool newline)
+        {
+            if (newline && end > fieldStart && data[end - 1] == '\r')
+                end--;
+            string_view text = data.substr(fieldStart, end - fieldStart);
+            if (inHeader)
+            {
+                header(text, quoted);
+                columns++;
+                inHeader = !newline;
+            }
+            else if (!(newline && column == 0 && text.empty()))
+            {
+                if (column < columns)
+                    field(column, text, quoted, rowStart);
+                column++;
+                if (newline)
+                {
+                    bool malformed = column != columns;
+                    for (; column < columns; column++)
+                        field(column, string_view(), false, rowStart);
+                    row(malformed);
+                    column = 0;
+                }
+            }
+            quoted = false;
+        };
+        auto special = [&](size_t p)
+        {
+            char c = data[p];
+            if (inQuotes)
+            {
+                if (c == '"')
+                    inQuotes = false; // "" redeschide imediat ghilimelele
+                return;
+            }
+            if (c == '"')
+            {
+                inQuotes = quoted = true;
+                return;
+            }
+            endField(p, c == '\n');
+            fieldStart = p + 1;
+            if (c == '\n')
+                rowStart = p + 1;
+        };
+        size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i comma = _mm_set1_epi8(delimiter);
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i newline = _mm_set1_epi8('\n');
+        for (; i + 64 <= data.size(); i += 64)
+        {
+            uint64_t mask = 0;
+            for (int part = 0; part < 4; part++)
+            {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data.data() + i + part * 16));
+                __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, comma), _mm_cmpeq_epi8(block, quote)), _mm_cmpeq_epi8(block, newline));
+                mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(hits))) << (part * 16);
+            }
+            for (; mask != 0; mask &= mask - 1)
+                special(i + lowestBit(mask));
+        }
+#endif
+        for (; i < data.size(); i++)
+        {
+            char c = data[i];
+            if (c == delimiter || c == '"' || c == '\n')
+                special(i);
+        }
+        // sfarsitul fisierului inchide ultimul rand, daca nu s-a terminat cu \n
+        if (fieldStart != data.size() || column != 0 || (inHeader && columns != 0))
+            endField(data.size(), true);
+    }
+
+    // campul "a ""b"" c" devine a "b" c
+    static string_view unquote(string_view value, string &unquoted)
+    {
+        unquoted.clear();
+        bool inQuotes = false;
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            if (value[i] == '"')
+            {
+                if (inQuotes && i + 1 < value.size() && value[i + 1] == '"')
+                {
+                    unquoted.push_back('"');
+                    i++;
+                }
+                else
+                    inQuotes = !inQuotes;
+            }
+            else
+                unquoted.push_back(value[i]);
+        }
+        return unquoted;
+    }
+
+    // Cifrele de la inceputul lui text (cel mult 18, deci fara depasire); intoarce cate au fost
+    static size_t digits(string_view text, size_t from, uint64_t &value)
+    {
+        size_t i = from;
+        for (; i < text.size() && i - from < 18 && static_cast<unsigned>(text[i] - '0') < 10; i++)
+            value = value * 10 + static_cast<unsigned>(text[i] - '0');
+        return i - from;
+    }
+
+    static bool parseInteger(string_view text, int64_t &value)
+    {
+        // cazul obisnuit, cel mult 18 cifre, direct; restul cu from_chars
+        bool negative = !text.empty() && text[0] == '-';
+        uint64_t whole = 0;
+        size_t count = digits(text, negative, whole);
+        if (count != 0 && negative + count == text.size())
+        {
+            value = negative ? -static_cast<int64_t>(whole) : static_cast<int64_t>(whole);
+            return true;
+        }
+        auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+        return error == errc() && end == text.data() + text.size();
+    }
+
+    static bool parseDouble(string_view text, double &value)
+    {
+        // 12.345: cel mult 15 cifre intra exact intr-un double, iar impartirea la o putere exacta a lui 10
+        // e rotunjita corect, deci rezultatul e acelasi ca de la from_chars
+        static constexpr double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+        bool negative = !text.empty() && text[0] == '-';
+        uint64_t mantissa = 0;
+        size_t whole = digits(text, negative, mantissa), fraction = 0;
+        size_t at = negative + whole;
+        if (whole != 0 && at < text.size() && text[at] == '.')
+            fraction = digits(text, at + 1, mantissa);
+        if (whole != 0 && whole + fraction <= 15 && at + (fraction != 0 ? fraction + 1 : 0) == text.size())
+        {
+            double number = static_cast<double>(mantissa) / powers[fraction];
+            value = negative ? -number : number;
+            return true;
+        }
+        auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+        return error == errc() && end == text.data() + text.size();
+    }
+
+    // Valoarea intra direct in bufferul coloanei. O coloana incepe ca integer si trece la double, apoi la text,
+    // la prima valoare care nu se potriveste. Trecerea la text reciteste coloana din randurile de dinainte
+    // (before = inceputul randului curent), o singura data pe coloana.
+    void append(string_view data, char delimiter, size_t index, string_view text, size_t before)
+    {
+        CsvColumn &column = columns[index];
+        if (column.type == CsvType::Integer)
+        {
+            int64_t integer;
+            if (parseInteger(text, integer))
+            {
+                column.integers.push_back(integer);
+                return;
+            }
+            column.numbers.assign(column.integers.begin(), column.integers.end());
+            column.integers = vector<int64_t>();
+            column.type = CsvType::Double;
+        }
+        if (column.type == CsvType::Double)
+        {
+            double number;
+            if (text.empty())
+            {
+                column.numbers.push_back(numeric_limits<double>::quiet_NaN());
+                return;
+            }
+            if (parseDouble(text, number))
+            {
+                column.numbers.push_back(number);
+                return;
+            }
+            column.numbers = vector<double>();
+            column.type = CsvType::Text;
+            string unquoted;
+            scan(
+                data.substr(0, before), delimiter, [](string_view, bool) {},
+                [&](size_t other, string_view earlier, bool quoted, size_t)
+                {
+                    if (other != index)
+                        return;
+                    column.text.append(quoted ? unquote(earlier, unquoted) : earlier);
+                    column.textEnds.push_back(column.text.size());
+                },
+                [](bool) {});
+        }
+        column.text.append(text);
+        column.textEnds.push_back(column.text.size());
+    }
+
+public:
+    vector<CsvColumn> columns;
+    size_t rows = 0;
+    size_t malformedRows = 0; // randuri cu alt numar de campuri decat antetul
+
+    static shared_ptr<const CsvTable> parse(string_view data, char delimiter = ',')
+    {
+        auto table = make_shared<CsvTable>();
+        string unquoted;
+        scan(
+            data, delimiter,
+            [&](string_view text, bool quoted)
+            {
+                table->columns.emplace_back();
+                table->columns.back().name = string(quoted ? unquote(text, unquoted) : text);
+            },
+            [&](size_t column, string_view text, bool quoted, size_t rowStart)
+            { table->append(data, delimiter, column, quoted ? unquote(text, unquoted) : text, rowStart); },
+            [&](bool malformed)
+            {
+                table->rows++;
+                if (malformed)
+                    table->malformedRows++;
+            });
+        return table;
+    }
+
+    // Un director sau un tipar (data/*.csv) da un singur tabel, cu randurile fisierelor in ordinea numelui
+    static shared_ptr<const CsvTable> load(const string &fileName, string &error, char delimiter = ',')
+    {
+        if (InputFile::codecOf(fileName) != nullptr || FileSet::isSet(fileName))
+        {
+            string content;
+            if (!FileSet::readAll(fileName, ".csv", true, content, error))
+                return nullptr;
+            Metrics::shared().addBytes(Metrics::CsvRead, content.size());
+            return parse(content, delimiter);
+        }
+        MappedFile file;
+        if (!file.open(fileName))
+        {
+            error = "Cannot open csv file " + fileName;
+            return nullptr;
+        }
+        Metrics::shared().addBytes(Metrics::CsvRead, file.data().size());
+        return parse(file.data(), delimiter);
+    }
+
+    // Acelasi fisier, cu acelasi continut, este parsat o singura data
+    static shared_ptr<const CsvTable> cached(const string &fileName, string &error, char delimiter = ',')
+    {
+        uint64_t content;
+        if (!FileSet::fingerprint(fileName, ".csv", content))
+        {
+            error = "Cannot open csv file " + fileName;
+            return nullptr;
+        }
+        uint64_t key = Fingerprint().add("csv").add(content).add(static_cast<uint64_t>(delimiter)).get();
+        if (auto table = WorkCache::shared().find<CsvTable>(key))
+            return table;
+        auto table = load(fileName, error, delimiter);
+        if (table != nullptr)
+            WorkCache::shared().store(key, table, table->bytes());
+        return table;
+    }
+
+    size_t bytes() const
+    {
+        size_t total = sizeof(CsvTable);
+        for (auto &column : columns)
+            total += sizeof(CsvColumn) + column.integers.size() * sizeof(int64_t) + column.numbers.size() * sizeof(double) + column.text.size() + column.textEnds.size() * sizeof(uint64_t);
+        return total;
+    }
+
+    const CsvColumn *column(string_view name) const
+    {
+        for (auto &column : columns)
+        {
+            if (column.name == name)
+                return &column;
+        }
+        return nullptr;
+    }
+};
+
+// Numere citite in bloc, intr-un buffer continuu de double. Separatori: spatii, tab, linii noi, virgula si
+// punct si virgula. Fiecare numar e citit cu from_chars (fara alocari, nu depinde de locale); se accepta
+// semnul, zecimalele si exponentul. La primul text care nu e numar citirea se opreste si se retine pozitia.
+struct NumberList
+{
+    vector<double> values;
+    bool failed = false;
+    size_t errorLine = 0, errorColumn = 0; // de la 1, coloana in octeti
+    string errorText;                      // textul gresit, cel mult 32 de octeti
+    bool outOfRange = false;
+
+    static constexpr array<bool, 256> separators = []
+    {
+        array<bool, 256> table{};
+        for (unsigned char c : {' ', '\t', '\r', '\n', '\v', '\f', ',', ';'})
+            table[c] = true;
+        return table;
+    }();
+
+    static bool isSeparator(char c)
+    {
+        return separators[static_cast<unsigned char>(c)];
+    }
+
+    string describeError() const
+    {
+        return "line " + to_string(errorLine) + ", column " + to_string(errorColumn) + ": '" + errorText + (outOfRange ? "' is out of range" : "' is not a number");
+    }
+
+    // Adauga la values numerele din text; intoarce false (si pozitia in errorLine / errorColumn) la primul text gresit
+    bool append(string_view text)
+    {
+        const char *begin = text.data(), *p = begin, *end = begin + text.size();
+        // cate numere sunt, estimat din primii 64 KB; daca sunt mai multe vectorul creste singur
+        size_t sample = min<size_t>(text.size(), 64 << 10), starts = 0;
+        for (size_t i = 0; i < sample; i++)
+            starts += !isSeparator(text[i]) && (i == 0 || isSeparator(text[i - 1]));
+        if (sample != 0)
+            values.reserve(values.size() + static_cast<size_t>(static_cast<double>(starts) * text.size() / sample) + 16);
+        while (true)
+        {
+            while (p != end && isSeparator(*p))
+                p++;
+            if (p == end)
+                return true;
+            const char *start = p;
+            if (*p == '+' && p + 1 != end && p[1] != '-') // from_chars nu accepta '+'
+                p++;
+            // intregii de cel mult 15 cifre sunt exacti ca double si se citesc direct
+            const char *digits = p + (*p == '-'), *q = digits;
+            uint64_t whole = 0;
+            while (q != end && static_cast<unsigned>(*q - '0') < 10 && q - digits < 16)
+                whole = whole * 10 + static_cast<unsigned>(*q++ - '0');
+            if (q != digits && q - digits <= 15 && (q == end || isSeparator(*q)))
+            {
+                values.push_back(*p == '-' ? -static_cast<double>(whole) : static_cast<double>(whole));
+                p = q;
+                continue;
+            }
+            double value;
+            auto [next, error] = from_chars(p, end, value);
+            if (error != errc() || (next != end && !isSeparator(*next)) || !isfinite(value))
+            {
+                const char *stop = start;
+                while (stop != end && !isSeparator(*stop) && stop - start < 32)
+                    stop++;
+                failed = true;
+                outOfRange = error == errc::result_out_of_range;
+                errorText.assign(start, stop);
+                errorLine = 1 + static_cast<size_t>(count(begin, start, '\n'));
+                const char *lineStart = start;
+                while (lineStart != begin && lineStart[-1] != '\n')
+                    lineStart--;
+                errorColumn = 1 + static_cast<size_t>(start - lineStart);
+                return false;
+            }
+            values.push_back(value);
+            p = next;
+        }
+    }
+
+    static shared_ptr<const NumberList> parse(string_view text)
+    {
+        auto list = make_shared<NumberList>();
+        list->append(text);
+        if (list->values.capacity() > list->values.size() + list->values.size() / 8)
+            list->values.shrink_to_fit(); // lista ramane in WorkCache, care o socoteste dupa size()
+        return list;
+    }
+
+    static shared_ptr<const NumberList> load(const string &fileName, string &error)
+    {
+        if (InputFile::codecOf(fileName) != nullptr)
+        {
+            string content;
+            if (!InputFile::readAll(fileName, content, error))
+                return nullptr;
+            Metrics::shared().addBytes(Metrics::TextRead, content.size());
+            return parse(content);
+        }
+        MappedFile file;
+        if (!file.open(fileName))
+        {
+            error = "Cannot open number file " + fileName;
+            return nullptr;
+        }
+        Metrics::shared().addBytes(Metrics::TextRead, file.data().size());
+        return parse(file.data());
+    }
+
+    // Acelasi fisier, cu acelasi continut, este citit o singura data
+    static shared_ptr<const NumberList> cached(const string &fileName, string &error)
+    {
+        uint64_t content;
+        if (!Fingerprint::ofFile(fileName, content))
+        {
+            error = "Cannot open number file " + fileName;
+            return nullptr;
+        }
+        uint64_t key = Fingerprint().add("numbers").add(content).get();
+        if (auto list = WorkCache::shared().find<NumberList>(key))
+            return list;
+        auto list = load(fileName, error);
+        if (list != nullptr)
+            WorkCache::shared().store(key, list, sizeof(NumberList) + list->values.size() * sizeof(double));
+        return list;
+    }
+};
+
+// Frecventa cuvintelor dintr-un text. Un cuvant este un sir de litere, cifre, '_' si octeti UTF-8 (>= 0x80);
+// literele ASCII sunt trecute la litere mici. Textul e impartit in bucati (la granita dintre cuvinte)
+// numarate in paralel, fiecare fir cu tabela lui; tabelele se unesc la sfarsit si se pastreaza doar
+// cele mai frecvente MaxTop cuvinte, plus totalurile.
+struct WordCounts
+{
+    static constexpr size_t MaxTop = 1000;
+    static constexpr size_t ChunkBytes = 4 << 20;  // sub atat nu merita un fir in plus
+    static constexpr size_t BlockBytes = 64 << 20; // cat se decomprima inainte de numarare
+
+    uint64_t bytes = 0, lines = 0, words = 0, distinct = 0;
+    vector<pair<string, uint64_t>> top; // descrescator dupa numar, apoi alfabetic
+
+private:
+    // 0 = separator, 1 = parte dintr-un cuvant, 2 = litera mare (A-Z)
+    static constexpr array<uint8_t, 256> byteClass = []
+    {
+        array<uint8_t, 256> table{};
+        for (int c = 0; c < 256; c++)
+        {
+            if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c >= 0x80)
+                table[c] = 1;
+            else if (c >= 'A' && c <= 'Z')
+                table[c] = 2;
+        }
+        return table;
+    }();
+
+    // Cate 8 octeti o data; cuvintele sunt scurte, deci de obicei una sau doua inmultiri
+    static uint64_t hashOf(string_view word)
+    {
+        uint64_t hash = 0x9e3779b97f4a7c15ull ^ word.size();
+        size_t i = 0;
+        for (; i + 8 <= word.size(); i += 8)
+        {
+            uint64_t chunk;
+            memcpy(&chunk, word.data() + i, 8);
+            hash = (hash ^ chunk) * 0x9ddfea08eb382d69ull;
+            hash ^= hash >> 32;
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, word.data() + i, word.size() - i);
+        hash = (hash ^ tail) * 0x9ddfea08eb382d69ull;
+        return hash ^ (hash >> 29);
+    }
+
+    // Tabela cu adresare deschisa a unui fir; cuvintele stau unul dupa altul in keys
+    struct Table
+    {
+        struct Slot
+        {
+            uint64_t hash = 0;
+            uint64_t offset = 0;
+            uint32_t length = 0;
+            uint64_t count = 0; // 0 = liber
+        };
+        vector<Slot> slots = vector<Slot>(1 << 12);
+        string keys;
+        size_t used = 0;
+        uint64_t words = 0, lines = 0;
+
+        string_view key(const Slot &slot) const
+        {
+            return string_view(keys.data() + slot.offset, slot.length);
+        }
+
+        void grow()
+        {
+            vector<Slot> old(slots.size() * 2);
+            old.swap(slots);
+            size_t mask = slots.size() - 1;
+            for (auto &slot : old)
+            {
+                if (slot.count == 0)
+                    continue;
+                size_t i = slot.hash & mask;
+                while (slots[i].count != 0)
+                    i = (i + 1) & mask;
+                slots[i] = slot;
+            }
+        }
+
+        void add(string_view word, uint64_t hash, uint64_t count)
+        {
+            size_t mask = slots.size() - 1;
+            size_t i = hash & mask;
+            while (slots[i].count != 0)
+            {
+                if (slots[i].hash == hash && key(slots[i]) == word)
+                {
+                    slots[i].count += count;
+                    return;
+                }
+                i = (i + 1) & mask;
+            }
+            slots[i] = {hash, keys.size(), static_cast<uint32_t>(word.size()), count};
+            keys += word;
+            if (++used * 2 > slots.size())
+                grow();
+        }
+
+        void addWord(string_view word, bool upper, string &folded)
+        {
+            if (upper)
+            {
+                folded.resize(word.size());
+                for (size_t i = 0; i < word.size(); i++)
+                    folded[i] = static_cast<char>(word[i] | (byteClass[static_cast<uint8_t>(word[i])] & 2) << 4); // 'A' | 0x20 = 'a'
+                word = folded;
+            }
+            words++;
+            add(word, hashOf(word), 1);
+        }
+
+        // Cuvintele se gasesc pe masti de biti (cate una pe 64 de octeti), fara un test pentru fiecare octet
+        void count(string_view text)
+        {
+            const char *data = text.data();
+            size_t size = text.size(), start = string::npos; // start: cuvantul inceput in blocul anterior
+            bool upper = false;
+            string folded;
+            for (size_t base = 0; base < size; base += 64)
+            {
+                Masks block = classify(data + base, min<size_t>(64, size - base));
+                lines += popcount(block.newlines);
+                uint64_t word = block.word;
+                if (start != string::npos)
+                {
+                    if (~word == 0)
+                    {
+                        upper |= block.upper != 0;
+                        continue;
+                    }
+                    unsigned end = countr_zero(~word);
+                    uint64_t inside = (1ull << end) - 1;
+                    addWord(text.substr(start, base + end - start), upper || (block.upper & inside) != 0, folded);
+                    word &= ~inside;
+                    start = string::npos;
+                }
+                while (word != 0)
+                {
+                    unsigned first = countr_zero(word);
+                    uint64_t after = ~word & (~0ull << first);
+                    if (after == 0)
+                    {
+                        start = base + first;
+                        upper = (block.upper >> first) != 0;
+                        break;
+                    }
+                    unsigned end = countr_zero(after);
+                    uint64_t inside = ((1ull << end) - 1) & ~((1ull << first) - 1);
+                    addWord(text.substr(base + first, end - first), (block.upper & inside) != 0, folded);
+                    word &= ~((1ull << end) - 1);
+                }
+            }
+            if (start != string::npos)
+                addWord(text.substr(start), upper, folded);
+        }
+    };
+
+    struct Masks
+    {
+        uint64_t word = 0, upper = 0, newlines = 0;
+    };
+
+    // Clasele a cel mult 64 de octeti, cate un bit pentru fiecare
+    static Masks classify(const char *p, size_t count)
+    {
+        Masks masks;
+#if defined(__SSE2__) || defined(_M_X64)
+        if (count == 64)
+        {
+            auto inRange = [](__m128i bytes, char low, char high)
+            {
+                __m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8(low));
+                return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(static_cast<char>(high - low))), shifted);
+            };
+            for (int part = 0; part < 4; part++)
+            {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + part * 16));
+                __m128i upper = inRange(bytes, 'A', 'Z');
+                __m128i word = _mm_or_si128(_mm_or_si128(upper, inRange(bytes, 'a', 'z')), _mm_or_si128(inRange(bytes, '0', '9'), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_'))));
+                int shift = part * 16;
+                masks.word |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(word) | _mm_movemask_epi8(bytes))) << shift;
+                masks.upper |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(upper))) << shift;
+                masks.newlines |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))))) << shift;
+            }
+            return masks;
+        }
+#endif
+        for (size_t i = 0; i < count; i++)
+        {
+            uint8_t kind = byteClass[static_cast<uint8_t>(p[i])];
+            masks.word |= static_cast<uint64_t>(kind != 0) << i;
+            masks.upper |= static_cast<uint64_t>(kind == 2) << i;
+            masks.newlines |= static_cast<uint64_t>(p[i] == '\n') << i;
+        }
+        return masks;
+    }
+
+    static bool inWord(char c)
+    {
+        return byteClass[static_cast<uint8_t>(c)] != 0;
+    }
+
+    // Un bloc care se termina la granita dintre cuvinte, impartit intre tabelele firelor (cel mult cate una pe bucata)
+    static void countBlock(string_view text, vector<Table> &tables)
+    {
+        size_t threads = max<size_t>(1, min(tables.size(), text.size() / ChunkBytes));
+
+        // Bucata i incepe dupa ultimul cuvant inceput in bucata i - 1
+        vector<size_t> starts{0};
+        for (size_t i = 1; i < threads; i++)
+        {
+            size_t start = max(starts.back(), text.size() / threads * i);
+            while (start < text.size() && start > 0 && inWord(text[start - 1]))
+                start++;
+            starts.push_back(start);
+        }
+        starts.push_back(text.size());
+
+        vector<thread> workers;
+        for (size_t i = 1; i < threads; i++)
+            workers.emplace_back([&, i]
+                                 { tables[i].count(text.substr(starts[i], starts[i + 1] - starts[i])); });
+        tables[0].count(text.substr(0, starts[1]));
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    static shared_ptr<const WordCounts> collect(vector<Table> &tables, uint64_t bytes, bool lastLineOpen)
+    {
+        Table &total = tables[0];
+        for (size_t i = 1; i < tables.size(); i++)
+        {
+            for (auto &slot : tables[i].slots)
+            {
+                if (slot.count != 0)
+                    total.add(tables[i].key(slot), slot.hash, slot.count);
+            }
+            total.words += tables[i].words;
+            total.lines += tables[i].lines;
+        }
+
+        auto result = make_shared<WordCounts>();
+        result->bytes = bytes;
+        result->lines = total.lines + lastLineOpen;
+        result->words = total.words;
+        result->distinct = total.used;
+        vector<const Table::Slot *> slots;
+        slots.reserve(total.used);
+        for (auto &slot : total.slots)
+        {
+            if (slot.count != 0)
+                slots.push_back(&slot);
+        }
+        auto before = [&total](const Table::Slot *a, const Table::Slot *b)
+        {
+            return a->count != b->count ? a->count > b->count : total.key(*a) < total.key(*b);
+        };
+        size_t kept = min(MaxTop, slots.size());
+        partial_sort(slots.begin(), slots.begin() + kept, slots.end(), before);
+        for (size_t i = 0; i < kept; i++)
+            result->top.emplace_back(string(total.key(*slots[i])), slots[i]->count);
+        return result;
+    }
+
+    static size_t defaultThreads()
+    {
+        return max(1u, thread::hardware_concurrency());
+    }
+
+public:
+    // threads = 0: cate fire are masina
+    static shared_ptr<const WordCounts> count(string_view text, size_t threads = 0)
+    {
+        vector<Table> tables(max<size_t>(1, min(threads == 0 ? defaultThreads() : threads, text.size() / ChunkBytes)));
+        countBlock(text, tables);
+        return collect(tables, text.size(), !text.empty() && text.back() != '\n');
+    }
+
+    // Fisierele comprimate se numara pe blocuri, pe masura ce sunt decomprimate; un cuvant
+    // neterminat la sfarsitul unui bloc trece in blocul urmator
+    static shared_ptr<const WordCounts> load(const string &fileName, string &error)
+    {
+        if (FileSet::isSet(fileName))
+            return loadSet(fileName, error);
+        if (InputFile::codecOf(fileName) == nullptr)
+        {
+            MappedFile file;
+            if (!file.open(fileName))
+            {
+                error = "Cannot open text file " + fileName;
+                return nullptr;
+            }
+            Metrics::shared().addBytes(Metrics::TextRead, file.data().size());
+            return count(file.data());
+        }
+        InputFile file;
+        if (!file.open(fileName))
+        {
+            error = file.error().empty() ? "Cannot open text file " + fileName : file.error();
+            return nullptr;
+        }
+        vector<Table> tables(defaultThreads());
+        string block;
+        size_t carried = 0;
+        uint64_t bytes = 0;
+        char last = '\n';
+        while (true)
+        {
+            block.resize(carried + BlockBytes);
+            size_t length = file.read(block.data() + carried, BlockBytes);
+            if (length == 0)
+            {
+                countBlock(string_view(block.data(), carried), tables);
+                break;
+            }
+            bytes += length;
+            length += carried;
+            last = block[length - 1];
+            size_t cut = length;
+            while (cut > 0 && inWord(block[cut - 1]))
+                cut--;
+            countBlock(string_view(block.data(), cut), tables);
+            carried = length - cut;
+            memmove(block.data(), block.data() + cut, carried);
+        }
+        if (!file.close())
+        {
+            error = "Cannot decompress " + fileName + " (" + file.error() + ")";
+            return nullptr;
+        }
+        Metrics::shared().addBytes(Metrics::TextRead, bytes);
+        return collect(tables, bytes, last != '\n');
+    }
+
+    // Fisierele setului sunt numarate pe toate firele cat timp urmatoarele sunt citite. Bucatile se aduna
+    // intr-un bloc, ca fiecare fir sa aiba ce numara; un cuvant neterminat la sfarsitul blocului trece mai departe.
+    static shared_ptr<const WordCounts> loadSet(const string &fileName, string &error)
+    {
+        FileSet::Reader reader(FileSet::expand(fileName, ".txt"), false);
+        if (reader.size() == 0)
+        {
+            error = "No files match " + fileName;
+            return nullptr;
+        }
+        vector<Table> tables(defaultThreads());
+        size_t blockBytes = tables.size() * ChunkBytes;
+        string block;
+        uint64_t bytes = 0;
+        FileSet::Chunk chunk;
+        while (reader.next(chunk))
+        {
+            if (!chunk.error.empty())
+            {
+                error = chunk.error;
+                return nullptr;
+            }
+            bytes += chunk.data().size();
+            block += chunk.data();
+            if (block.size() >= blockBytes)
+            {
+                size_t cut = block.size();
+                while (cut > 0 && inWord(block[cut - 1]))
+                    cut--;
+                countBlock(string_view(block.data(), cut), tables);
+                block.erase(0, cut);
+            }
+        }
+        countBlock(block, tables);
+        Metrics::shared().addBytes(Metrics::TextRead, bytes);
+        return collect(tables, bytes, false);
+    }
+
+    // Acelasi fisier, cu acelasi continut, este numarat o singura data
+    static shared_ptr<const WordCounts> cached(const string &fileName, string &error)
+    {
+        uint64_t content;
+        if (!FileSet::fingerprint(fileName, ".txt", content))
+        {
+            error = "Cannot open text file " + fileName;
+            return nullptr;
+        }
+        uint64_t key = Fingerprint().add("words").add(content).get();
+        if (auto counts = WorkCache::shared().find<WordCounts>(key))
+            return counts;
+        auto counts = load(fileName, error);
+        if (counts != nullptr)
+            WorkCache::shared().store(key, counts, counts->memory());
+        return counts;
+    }
+
+    size_t memory() const
+    {
+        size_t total = sizeof(WordCounts) + top.size() * sizeof(top[0]);
+        for (auto &[word, count] : top)
+            total += word.size();
+        return total;
+    }
+};
+
+enum class CalcOp : uint8_t
+{
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Min,
+    Max
+};
+
+// Operatii element cu element pe coloane de double. Un operand "broadcast" este un singur numar aplicat
+// fiecarui rand. Impartirea la zero da NaN pe randul respectiv si este numarata, nu opreste calculul.
+class ColumnMath
+{
+public:
+    struct Operand
+    {
+        const double *values;
+        bool broadcast;
+    };
+
+    static bool parseOp(string_view text, CalcOp &op)
+    {
+        static constexpr pair<string_view, CalcOp> names[] = {{"+", CalcOp::Add}, {"-", CalcOp::Subtract}, {"*", CalcOp::Multiply}, {"/", CalcOp::Divide}, {"min", CalcOp::Min}, {"max", CalcOp::Max}};
+        for (auto &[name, value] : names)
+        {
+            if (name == text)
+            {
+                op = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static double applyOne(CalcOp op, double a, double b)
+    {
+        switch (op)
+        {
+        case CalcOp::Add:
+            return a + b;
+        case CalcOp::Subtract:
+            return a - b;
+        case CalcOp::Multiply:
+            return a * b;
+        case CalcOp::Divide:
+            return b == 0 ? numeric_limits<double>::quiet_NaN() : a / b;
+        case CalcOp::Min:
+            return b < a ? b : a;
+        case CalcOp::Max:
+            return a < b ? b : a;
+        }
+        return 0;
+    }
+
+    // Scrie rows rezultate in out si intoarce numarul de impartiri la zero
+    static size_t apply(CalcOp op, Operand a, Operand b, double *out, size_t rows)
+    {
+        size_t i = 0, zeros = 0;
+#if defined(__AVX__)
+        zeros += vectorized<Avx>(op, a, b, out, rows, i);
+#elif defined(__SSE2__) || defined(_M_X64)
+        zeros += vectorized<Sse2>(op, a, b, out, rows, i);
+#endif
+        for (; i < rows; i++)
+        {
+            double x = a.broadcast ? a.values[0] : a.values[i];
+            double y = b.broadcast ? b.values[0] : b.values[i];
+            if (op == CalcOp::Divide && y == 0)
+                zeros++;
+            out[i] = applyOne(op, x, y);
+        }
+        return zeros;
+    }
+
+private:
+#if defined(__SSE2__) || defined(_M_X64)
+    struct Sse2
+    {
+        using Vector = __m128d;
+        static constexpr size_t width = 2;
+        static Vector load(const double *p) { return _mm_loadu_pd(p); }
+        static void store(double *p, Vector v) { _mm_storeu_pd(p, v); }
+        static Vector set(double x) { return _mm_set1_pd(x); }
+        static Vector add(Vector x, Vector y) { return _mm_add_pd(x, y); }
+        static Vector sub(Vector x, Vector y) { return _mm_sub_pd(x, y); }
+        static Vector mul(Vector x, Vector y) { return _mm_mul_pd(x, y); }
+        static Vector div(Vector x, Vector y) { return _mm_div_pd(x, y); }
+        static Vector min(Vector x, Vector y) { return _mm_min_pd(y, x); } // ca std::min: la egalitate sau NaN ramane x
+        static Vector max(Vector x, Vector y) { return _mm_max_pd(y, x); }
+        static Vector isZero(Vector x) { return _mm_cmpeq_pd(x, _mm_setzero_pd()); }
+        static int bits(Vector mask) { return _mm_movemask_pd(mask); }
+        static Vector select(Vector mask, Vector yes, Vector no) { return _mm_or_pd(_mm_and_pd(mask, yes), _mm_andnot_pd(mask, no)); }
+    };
+#endif
+#if defined(__AVX__)
+    struct Avx
+    {
+        using Vector = __m256d;
+        static constexpr size_t width = 4;
+        static Vector load(const double *p) { return _mm256_loadu_pd(p); }
+        static void store(double *p, Vector v) { _mm256_storeu_pd(p, v); }
+        static Vector set(double x) { return _mm256_set1_pd(x); }
+        static Vector add(Vector x, Vector y) { return _mm256_add_pd(x, y); }
+        static Vector sub(Vector x, Vector y) { return _mm256_sub_pd(x, y); }
+        static Vector mul(Vector x, Vector y) { return _mm256_mul_pd(x, y); }
+        static Vector div(Vector x, Vector y) { return _mm256_div_pd(x, y); }
+        static Vector min(Vector x, Vector y) { return _mm256_min_pd(y, x); }
+        static Vector max(Vector x, Vector y) { return _mm256_max_pd(y, x); }
+        static Vector isZero(Vector x) { return _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_EQ_OQ); }
+        static int bits(Vector mask) { return _mm256_movemask_pd(mask); }
+        static Vector select(Vector mask, Vector yes, Vector no) { return _mm256_blendv_pd(no, yes, mask); }
+    };
+#endif
+
+    template <typename Isa, typename Kernel>
+    static void loop(Operand a, Operand b, double *out, size_t rows, size_t &i, Kernel kernel)
+    {
+        using Vector = typename Isa::Vector;
+        const Vector scalarA = Isa::set(a.values[0]), scalarB = Isa::set(b.values[0]);
+        for (; i + Isa::width <= rows; i += Isa::width)
+        {
+            Vector x = a.broadcast ? scalarA : Isa::load(a.values + i);
+            Vector y = b.broadcast ? scalarB : Isa::load(b.values + i);
+            Isa::store(out + i, kernel(x, y));
+        }
+    }
+
+    template <typename Isa>
+    static size_t vectorized(CalcOp op, Operand a, Operand b, double *out, size_t rows, size_t &i)
+    {
+        using Vector = typename Isa::Vector;
+        if (rows == 0)
+            return 0;
+        size_t zeros = 0;
+        switch (op)
+        {
+        case CalcOp::Add:
+            loop<Isa>(a, b, out, rows, i, [](Vector x, Vector y)
+                      { return Isa::add(x, y); });
+            break;
+        case CalcOp::Subtract:
+            loop<Isa>(a, b, out, rows, i, [](Vector x, Vector y)
+                      { return Isa::sub(x, y); });
+            break;
+        case CalcOp::Multiply:
+            loop<Isa>(a, b, out, rows, i, [](Vector x, Vector y)
+                      { return Isa::mul(x, y); });
+            break;
+        case CalcOp::Divide:
+        {
+            const Vector nan = Isa::set(numeric_limits<double>::quiet_NaN());
+            loop<Isa>(a, b, out, rows, i, [&](Vector x, Vector y)
+                      {
+                          Vector zero = Isa::isZero(y);
+                          zeros += popcount(static_cast<unsigned>(Isa::bits(zero)));
+                          return Isa::select(zero, nan, Isa::div(x, y)); });
+            break;
+        }
+        case CalcOp::Min:
+            loop<Isa>(a, b, out, rows, i, [](Vector x, Vector y)
+                      { return Isa::min(x, y); });
+            break;
+        case CalcOp::Max:
+            loop<Isa>(a, b, out, rows, i, [](Vector x, Vector y)
+                      { return Isa::max(x, y); });
+            break;
+        }
+        return zeros;
+    }
+};
+
+// Expresie aritmetica, de ex. (pret + taxa) * max(cant, 1) / n2, compilata o data intr-un program pentru
+// o masina cu stiva. Evaluarea nu compara texte si nu aloca memorie; variabilele primesc valori dupa index.
+class Expression
+{
+public:
+    static constexpr size_t MaxDepth = 64;
+
+private:
+    enum class Code : uint8_t
+    {
+        Constant,
+        Variable,
+        Negate,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Min,
+        Max
+    };
+
+    struct Instruction
+    {
+        Code code;
+        uint16_t index; // pentru Constant si Variable
+    };
+
+    vector<Instruction> program;
+    vector<double> constants;
+    vector<string> variables;
+
+    // Parser recursiv: expr = term {(+|-) term}, term = unary {(*|/) unary}, unary = -unary | primary
+    struct Parser
+    {
+        string_view text;
+        size_t at = 0;
+        Expression &out;
+        size_t depth = 0, maxDepth = 0;
+        size_t nesting = 0;
+
+        void skipSpaces()
+        {
+            while (at < text.size() && isspace(static_cast<unsigned char>(text[at])))
+                at++;
+        }
+        bool accept(char c)
+        {
+            skipSpaces();
+            if (at < text.size() && text[at] == c)
+            {
+                at++;
+                return true;
+            }
+            return false;
+        }
+        void expect(char c)
+        {
+            if (!accept(c))
+                throw invalid_argument(string("Expected '") + c + "' at position " + to_string(at + 1) + ".");
+        }
+        void emit(Code code, uint16_t index = 0)
+        {
+            out.program.push_back({code, index});
+            if (code == Code::Constant || code == Code::Variable)
+                maxDepth = max(maxDepth, ++depth);
+            else if (code != Code::Negate)
+                depth--;
+        }
+
+        void expression()
+        {
+            term();
+            while (true)
+            {
+                if (accept('+'))
+                {
+                    term();
+                    emit(Code::Add);
+                }
+                else if (accept('-'))
+                {
+                    term();
+                    emit(Code::Subtract);
+                }
+                else
+                    return;
+            }
+        }
+        void term()
+        {
+            unary();
+            while (true)
+            {
+                if (accept('*'))
+                {
+                    unary();
+                    emit(Code::Multiply);
+                }
+                else if (accept('/'))
+                {
+                    unary();
+                    emit(Code::Divide);
+                }
+                else
+                    return;
+            }
+        }
+        void unary()
+        {
+            // fiecare paranteza, minus sau min/max trece pe aici; limitam recursia, nu doar stiva de evaluare
+            if (++nesting > MaxDepth)
+                throw invalid_argument("Expression is nested too deeply at position " + to_string(at + 1) + ".");
+            if (accept('-'))
+            {
+                unary();
+                emit(Code::Negate);
+            }
+            else
+                primary();
+            nesting--;
+        }
+        void primary()
+        {
+            skipSpaces();
+            if (accept('('))
+            {
+                expression();
+                expect(')');
+                return;
+            }
+            if (at < text.size() && (isdigit(static_cast<unsigned char>(text[at])) || text[at] == '.'))
+            {
+                double value;
+                auto [end, error] = from_chars(text.data() + at, text.data() + text.size(), value);
+                if (error != errc())
+                    throw invalid_argument("Invalid number at position " + to_string(at + 1) + ".");
+                at = end - text.data();
+                out.constants.push_back(value);
+                emit(Code::Constant, static_cast<uint16_t>(out.constants.size() - 1));
+                return;
+            }
+            size_t start = at;
+            while (at < text.size() && (isalnum(static_cast<unsigned char>(text[at])) || text[at] == '_'))
+                at++;
+            if (start == at)
+                throw invalid_argument("Expected a number, a name or '(' at position " + to_string(at + 1) + ".");
+            string_view name = text.substr(start, at - start);
+            if ((name == "min" || name == "max") && accept('('))
+            {
+                expression();
+                expect(',');
+                expression();
+                expect(')');
+                emit(name == "min" ? Code::Min : Code::Max);
+                return;
+            }
+            auto known = find(out.variables.begin(), out.variables.end(), name);
+            if (known == out.variables.end())
+                known = out.variables.insert(known, string(name));
+            emit(Code::Variable, static_cast<uint16_t>(known - out.variables.begin()));
+        }
+    };
+
+public:
+    // Arunca invalid_argument cu pozitia greselii
+    static Expression compile(string_view text)
+    {
+        Expression result;
+        Parser parser{text, 0, result};
+        parser.expression();
+        parser.skipSpaces();
+        if (parser.at != text.size())
+            throw invalid_argument("Unexpected '" + string(1, text[parser.at]) + "' at position " + to_string(parser.at + 1) + ".");
+        if (parser.maxDepth > MaxDepth || result.constants.size() > UINT16_MAX || result.variables.size() > UINT16_MAX)
+            throw invalid_argument("Expression is too large.");
+        return result;
+    }
+
+    // Aceeasi expresie folosita de mai multe rulari se compileaza o singura data. Textul vine de la utilizator,
+    // deci expresiile stau in WorkCache, care are o limita de memorie, nu intr-un tabel care doar creste.
+    static shared_ptr<const Expression> cached(string_view text)
+    {
+        uint64_t key = Fingerprint().add("expression").add(text).get();
+        if (auto expression = WorkCache::shared().find<Expression>(key))
+            return expression;
+        auto expression = make_shared<const Expression>(compile(text));
+        WorkCache::shared().store(key, expression, expression->bytes());
+        return expression;
+    }
+
+    size_t bytes() const
+    {
+        size_t total = sizeof(Expression) + program.size() * sizeof(Instruction) + constants.size() * sizeof(double);
+        for (auto &name : variables)
+            total += sizeof(string) + name.size();
+        return total;
+    }
+
+    const vector<string> &names() const
+    {
+        return variables;
+    }
+
+    // values[i] este valoarea variabilei names()[i]; impartirea la zero da NaN si seteaza divisionByZero
+    double evaluate(const double *values, bool &divisionByZero) const
+    {
+        double stack[MaxDepth];
+        size_t top = 0;
+        for (const Instruction &instruction : program)
+        {
+            switch (instruction.code)
+            {
+            case Code::Constant:
+                stack[top++] = constants[instruction.index];
+                break;
+            case Code::Variable:
+                stack[top++] = values[instruction.index];
+                break;
+            case Code::Negate:
+                stack[top - 1] = -stack[top - 1];
+                break;
+            case Code::Add:
+                top--;
+                stack[top - 1] += stack[top];
+                break;
+            case Code::Subtract:
+                top--;
+                stack[top - 1] -= stack[top];
+                break;
+            case Code::Multiply:
+                top--;
+                stack[top - 1] *= stack[top];
+                break;
+            case Code::Divide:
+                top--;
+                if (stack[top] == 0)
+                {
+                    divisionByZero = true;
+                    stack[top - 1] = numeric_limits<double>::quiet_NaN();
+                }
+                else
+                    stack[top - 1] /= stack[top];
+                break;
+            case Code::Min:
+                top--;
+                stack[top - 1] = min(stack[top - 1], stack[top]);
+                break;
+            case Code::Max:
+                top--;
+                stack[top - 1] = max(stack[top - 1], stack[top]);
+                break;
+            }
+        }
+        return stack[0];
+    }
+};
+
+// Coada cu un singur producator si un singur consumator, fara mutex; push/pop asteapta cand e plina/goala
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+private:
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    T items[Capacity];
+    alignas(64) atomic<size_t> head{0}; // urmatorul element citit de consumator
+    alignas(64) atomic<size_t> tail{0}; // urmatorul loc scris de producator
+
+public:
+    void push(T item)
+    {
+        size_t t = tail.load(memory_order_relaxed);
+        size_t h = head.load(memory_order_acquire);
+        while (t - h == Capacity)
+        {
+            head.wait(h, memory_order_acquire);
+            h = head.load(memory_order_acquire);
+        }
+        items[t % Capacity] = item;
+        tail.store(t + 1, memory_order_release);
+        tail.notify_one();
+    }
+
+    T pop()
+    {
+        size_t h = head.load(memory_order_relaxed);
+        size_t t = tail.load(memory_order_acquire);
+        while (t == h)
+        {
+            tail.wait(t, memory_order_acquire);
+            t = tail.load(memory_order_acquire);
+        }
+        T item = items[h % Capacity];
+        head.store(h + 1, memory_order_release);
+        head.notify_one();
+        return item;
+    }
+};
+
+// Trimite informatia unui pas spre fisier in bucati de marime fixa. Daca totul incape intr-o bucata
+// se scrie direct; altfel un fir separat scrie in timp ce pasul citeste mai departe, iar memoria
+// folosita ramane Chunks * ChunkSize indiferent de marimea fisierului citit.
+class ChunkPipe
+{
+public:
+    static constexpr size_t ChunkSize = 64 * 1024;
+    static constexpr size_t Chunks = 8;
+
+private:
+    struct Chunk
+    {
+        unique_ptr<char[]> data;
+        size_t length = 0;
+    };
+
+    static constexpr uint8_t Done = 0xFF;
+
+    function<bool(string_view)> writeChunk;
+    vector<Chunk> chunks;
+    SpscQueue<uint8_t, Chunks> freeChunks, fullChunks;
+    uint8_t current = Done;
+    uint8_t held = Done; // prima bucata asteapta: daca nu mai urmeaza alta nu pornim firul
+    thread writer;
+    atomic<bool> failed{false};
+
+    void writeLoop()
+    {
+        for (uint8_t index = fullChunks.pop(); index != Done; index = fullChunks.pop())
+        {
+            if (!failed.load(memory_order_relaxed) && !writeChunk(string_view(chunks[index].data.get(), chunks[index].length)))
+                failed.store(true, memory_order_relaxed);
+            freeChunks.push(index);
+        }
+    }
+
+    void send(uint8_t index)
+    {
+        if (!writer.joinable())
+        {
+            if (held == Done)
+            {
+                held = index;
+                return;
+            }
+            writer = thread(&ChunkPipe::writeLoop, this);
+            fullChunks.push(held);
+            held = Done;
+        }
+        fullChunks.push(index);
+    }
+
+public:
+    ChunkPipe(function<bool(string_view)> Write) : writeChunk(move(Write)), chunks(Chunks)
+    {
+        for (uint8_t i = 0; i < Chunks; i++)
+            freeChunks.push(i);
+    }
+
+    // Zona in care producatorul scrie urmatoarea bucata; commit() o trimite spre scriere
+    char *acquire()
+    {
+        if (current == Done)
+        {
+            current = freeChunks.pop();
+            if (!chunks[current].data)
+                chunks[current].data = make_unique<char[]>(ChunkSize);
+            chunks[current].length = 0;
+        }
+        return chunks[current].data.get() + chunks[current].length;
+    }
+    size_t available() const
+    {
+        return current == Done ? ChunkSize : ChunkSize - chunks[current].length;
+    }
+    void commit(size_t length)
+    {
+        chunks[current].length += length;
+        if (chunks[current].length == ChunkSize)
+            flush();
+    }
+    void flush()
+    {
+        if (current == Done || chunks[current].length == 0)
+            return;
+        uint8_t index = current;
+        current = Done;
+        send(index);
+    }
+
+    void write(string_view text)
+    {
+        while (!text.empty())
+        {
+            size_t length = min(available(), text.size());
+            memcpy(acquire(), text.data(), length);
+            text.remove_prefix(length);
+            commit(length);
+        }
+    }
+
+    // Asteapta scrierea tuturor bucatilor; intoarce false daca una nu a putut fi scrisa
+    bool finish()
+    {
+        flush();
+        if (writer.joinable())
+        {
+            fullChunks.push(Done);
+            writer.join();
+        }
+        else if (held != Done)
+        {
+            if (!writeChunk(string_view(chunks[held].data.get(), chunks[held].length)))
+                failed = true;
+            freeChunks.push(held);
+            held = Done;
+        }
+        return !failed;
+    }
+
+    ~ChunkPipe()
+    {
+        finish();
+    }
+};
+
+enum class Durability : uint8_t
+{
+    None,        // datele ajung in fisier cand bufferul se umple, periodic sau la inchidere; fara fsync
+    Periodic,    // ca None, plus fsync la fiecare everyMs
+    GroupCommit // o inregistrare e terminata abia dupa fsync; un fsync acopera toate inregistrarile adunate
+};
+
+struct DurabilityPolicy
+{
+    Durability mode = Durability::None;
+    int everyRecords = 64; // GroupCommit: fsync dupa atatea inregistrari...
+    int everyMs = 5;       // ...sau dupa atatea milisecunde
+};
+
+// Scriitor de lunga durata pentru un fisier de iesire, impartit de toate rularile care scriu in el.
+// Inregistrarile mici se strang intr-un buffer mare; una mare se scrie impreuna cu bufferul intr-un singur lot.
+// Bufferul plin se scrie prin AsyncIO cat timp inregistrarile urmatoare se strang in al doilea buffer.
+class OutputWriter
+{
+public:
+    static constexpr size_t BufferSize = 1 << 20;
+
+private:
+    string path;
+    DurabilityPolicy policy;
+    int fd = -1;
+    mutex lock;           // o singura inregistrare scrisa la un moment dat
+    mutex stateLock;      // bufferul si contoarele de fsync
+    condition_variable synced, wake;
+    vector<char> buffer;
+    uint64_t records = 0, syncedRecords = 0;
+    bool syncing = false, stopping = false;
+    atomic<bool> failed{false};
+    chrono::steady_clock::time_point firstUnsynced;
+    thread flusher;
+#ifndef _WIN32
+    vector<char> writing; // bufferul trimis la scriere
+    future<int64_t> written;
+    AsyncIO::Request writingRequest{};
+    uint64_t offset = 0; // unde ajunge urmatoarea scriere
+#endif
+
+    static inline mutex registryLock;
+    static inline unordered_map<string, unique_ptr<OutputWriter>> writers;
+    static inline DurabilityPolicy defaultPolicy;
+
+#ifdef _WIN32
+    bool writeParts(string_view first, string_view second)
+    {
+        for (string_view part : {first, second})
+        {
+            while (!part.empty())
+            {
+                int written = _write(fd, part.data(), static_cast<unsigned>(min<size_t>(part.size(), 1 << 30)));
+                if (written <= 0)
+                    return false;
+                part.remove_prefix(written);
+            }
+        }
+        return true;
+    }
+#else
+    // Restul unei scrieri scurte se trimite din nou
+    void finishWrite(future<int64_t> &result, AsyncIO::Request request)
+    {
+        size_t total = request.length;
+        int64_t moved = result.get();
+        while (moved > 0 && static_cast<size_t>(moved) < request.length)
+        {
+            request.data += moved;
+            request.length -= static_cast<size_t>(moved);
+            request.offset += static_cast<uint64_t>(moved);
+            moved = AsyncIO::shared().submit(request).get();
+        }
+        if (moved <= 0 && total != 0)
+            failed = true;
+        else
+            Metrics::shared().addBytes(Metrics::OutputWritten, total);
+    }
+
+    // Asteapta scrierea bufferului trimis anterior
+    void awaitWrite()
+    {
+        if (!written.valid())
+            return;
+        finishWrite(written, writingRequest);
+        writing.clear();
+    }
+#endif
+
+    bool syncFile()
+    {
+#ifdef _WIN32
+        return _commit(fd) == 0;
+#elif defined(__APPLE__)
+        return fsync(fd) == 0;
+#else
+        return fdatasync(fd) == 0;
+#endif
+    }
+
+    // Se apeleaza cu stateLock luat. Bufferul pleaca la scriere fara asteptare; o bucata mare primita
+    // de la apelant este asteptata, memoria ei nu apartine scriitorului.
+    void drain(string_view extra = {})
+    {
+        if (buffer.empty() && extra.empty())
+            return;
+#ifdef _WIN32
+        if (!writeParts(string_view(buffer.data(), buffer.size()), extra))
+            failed = true;
+        else
+            Metrics::shared().addBytes(Metrics::OutputWritten, buffer.size() + extra.size());
+#else
+        awaitWrite();
+        AsyncIO::Request parts[2];
+        size_t count = 0;
+        for (string_view part : {string_view(buffer.data(), buffer.size()), extra})
+        {
+            if (part.empty())
+                continue;
+            parts[count++] = {fd, const_cast<char *>(part.data()), part.size(), offset, true};
+            offset += part.size();
+        }
+        auto results = AsyncIO::shared().submit(parts, count);
+        if (!extra.empty())
+            finishWrite(results.back(), parts[count - 1]);
+        if (!buffer.empty())
+        {
+            written = move(results.front());
+            writingRequest = parts[0];
+            swap(buffer, writing);
+        }
+#endif
+        buffer.clear();
+    }
+
+    // Tot ce s-a strans a ajuns in fisier
+    void drainAll()
+    {
+        drain();
+#ifndef _WIN32
+        awaitWrite();
+#endif
+    }
+
+    // Un singur fir face fsync; celelalte asteapta rezultatul lui (group commit)
+    void commit(unique_lock<mutex> &state, uint64_t upTo)
+    {
+        while (syncedRecords < upTo)
+        {
+            if (syncing)
+            {
+                synced.wait(state);
+                continue;
+            }
+            syncing = true;
+            drainAll();
+            uint64_t covered = records;
+            state.unlock();
+            bool ok = syncFile();
+            state.lock();
+            syncing = false;
+            if (!ok)
+                failed = true;
+            syncedRecords = max(syncedRecords, covered);
+            synced.notify_all();
+        }
+    }
+
+    void flushLoop()
+    {
+        unique_lock<mutex> state(stateLock);
+        while (!stopping)
+        {
+            wake.wait_for(state, chrono::milliseconds(policy.everyMs));
+            if (policy.mode == Durability::None)
+                drain();
+            else
+                commit(state, records);
+        }
+    }
+
+public:
+    OutputWriter(const string &Path, DurabilityPolicy Policy) : path(Path), policy(Policy)
+    {
+#ifdef _WIN32
+        fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        off_t end = fd >= 0 ? lseek(fd, 0, SEEK_END) : 0;
+        offset = static_cast<uint64_t>(max<off_t>(end, 0)); // scrierile au pozitie, nu O_APPEND
+        writing.reserve(BufferSize);
+#endif
+        buffer.reserve(BufferSize);
+        if (fd >= 0)
+            flusher = thread(&OutputWriter::flushLoop, this);
+    }
+    OutputWriter(const OutputWriter &) = delete;
+    OutputWriter &operator=(const OutputWriter &) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+
+    // Scriitorul comun pentru un fisier; se deschide la prima folosire
+    static OutputWriter &forFile(const string &path)
+    {
+        lock_guard<mutex> guard(registryLock);
+        auto &writer = writers[path];
+        if (!writer || !writer->isOpen())
+            writer = make_unique<OutputWriter>(path, defaultPolicy);
+        return *writer;
+    }
+
+    static void setDefaultPolicy(DurabilityPolicy policy)
+    {
+        lock_guard<mutex> guard(registryLock);
+        defaultPolicy = policy;
+    }
+
+    static void closeAll()
+    {
+        lock_guard<mutex> guard(registryLock);
+        writers.clear();
+    }
+
+    // O inregistrare: bucatile ei ajung in fisier una dupa alta, fara bucati din alte rulari intre ele
+    class Record
+    {
+    private:
+        OutputWriter &writer;
+        unique_lock<mutex> hold;
+
+    public:
+        Record(OutputWriter &Writer) : writer(Writer), hold(Writer.lock) {}
+        Record(const Record &) = delete;
+        Record &operator=(const Record &) = delete;
+
+        bool write(string_view chunk)
+        {
+            lock_guard<mutex> state(writer.stateLock);
+            if (writer.buffer.size() + chunk.size() <= BufferSize)
+                writer.buffer.insert(writer.buffer.end(), chunk.begin(), chunk.end());
+            else if (chunk.size() >= BufferSize / 2)
+                writer.drain(chunk);
+            else
+            {
+                writer.drain();
+                writer.buffer.insert(writer.buffer.end(), chunk.begin(), chunk.end());
+            }
+            return !writer.failed;
+        }
+
+        // Intoarce false daca ceva din fisier nu a putut fi scris
+        bool finish()
+        {
+            if (!hold.owns_lock())
+                return !writer.failed;
+            unique_lock<mutex> state(writer.stateLock);
+            uint64_t number = ++writer.records;
+            hold.unlock();
+            if (writer.policy.mode == Durability::GroupCommit)
+            {
+                if (number == writer.syncedRecords + 1)
+                    writer.firstUnsynced = chrono::steady_clock::now();
+                if (number - writer.syncedRecords >= static_cast<uint64_t>(writer.policy.everyRecords) ||
+                    chrono::steady_clock::now() - writer.firstUnsynced >= chrono::milliseconds(writer.policy.everyMs))
+                    writer.commit(state, number);
+                else
+                    writer.synced.wait(state, [&]
+                                       { return writer.syncedRecords >= number; }); // fsync-ul il face flusher-ul sau un alt scriitor
+            }
+            return !writer.failed;
+        }
+
+        ~Record()
+        {
+            finish();
+        }
+    };
+
+    // Scrie tot ce e in buffer (si face fsync, daca politica o cere) si inchide fisierul
+    ~OutputWriter()
+    {
+        {
+            unique_lock<mutex> state(stateLock);
+            stopping = true;
+            wake.notify_all();
+        }
+        if (flusher.joinable())
+            flusher.join();
+        if (fd < 0)
+            return;
+        {
+            unique_lock<mutex> state(stateLock);
+            drainAll();
+            if (policy.mode != Durability::None)
+                syncFile();
+        }
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+};
+
+// Rezultatul unei singure treceri printr-un text: daca e UTF-8 corect, cate caractere (puncte de cod) are
+// si daca e format doar din spatii albe
+struct TextScan
+{
+    bool valid = true;
+    bool blank = true;
+    size_t codePoints = 0;
+};
+
+// Validare UTF-8 cu un automat construit la compilare (ca in Hoehrmann, "Flexible and Economical UTF-8 Decoder").
+// Blocurile de 16 octeti ASCII sunt trecute cu SSE2 fara automat; in celelalte caracterele se numara tot cu SSE2
+// (octetii care nu sunt de continuare), iar automatul trece doar prin octetii peste 7F.
+class Utf8
+{
+private:
+    enum Class : uint8_t
+    {
+        Ascii,
+        Cont80,   // 80..8F
+        Cont90,   // 90..9F
+        ContA0,   // A0..BF
+        Invalid,  // C0, C1, F5..FF
+        Lead2,    // C2..DF
+        LeadE0,   // urmat de A0..BF (fara forme prea lungi)
+        Lead3,    // E1..EC, EE, EF
+        LeadED,   // urmat de 80..9F (fara surogate)
+        LeadF0,   // urmat de 90..BF
+        Lead4,    // F1..F3
+        LeadF4,   // urmat de 80..8F (cel mult U+10FFFF)
+        Classes
+    };
+    enum State : uint8_t
+    {
+        Accept,
+        Reject,
+        Need1,   // mai trebuie un octet de continuare
+        Need2,
+        Need3,
+        AfterE0, // al doilea octet dupa E0
+        AfterED,
+        AfterF0,
+        AfterF4,
+        States
+    };
+
+    static constexpr array<uint8_t, 256> classes = []
+    {
+        array<uint8_t, 256> table{};
+        for (int b = 0; b < 256; b++)
+        {
+            table[b] = b < 0x80   ? Ascii
+                       : b < 0x90 ? Cont80
+                       : b < 0xA0 ? Cont90
+                       : b < 0xC0 ? ContA0
+                       : b < 0xC2 ? Invalid
+                       : b < 0xE0 ? Lead2
+                       : b == 0xE0 ? LeadE0
+                       : b == 0xED ? LeadED
+                       : b < 0xF0 ? Lead3
+                       : b == 0xF0 ? LeadF0
+                       : b < 0xF4 ? Lead4
+                       : b == 0xF4 ? LeadF4
+                                   : Invalid;
+        }
+        return table;
+    }();
+
+    static constexpr array<array<uint8_t, Classes>, States> transitions = []
+    {
+        array<array<uint8_t, Classes>, States> table{};
+        for (auto &row : table)
+            row.fill(Reject);
+        table[Accept][Ascii] = Accept;
+        table[Accept][Lead2] = Need1;
+        table[Accept][LeadE0] = AfterE0;
+        table[Accept][Lead3] = Need2;
+        table[Accept][LeadED] = AfterED;
+        table[Accept][LeadF0] = AfterF0;
+        table[Accept][Lead4] = Need3;
+        table[Accept][LeadF4] = AfterF4;
+        for (uint8_t c : {Cont80, Cont90, ContA0})
+        {
+            table[Need1][c] = Accept;
+            table[Need2][c] = Need1;
+            table[Need3][c] = Need2;
+        }
+        table[AfterE0][ContA0] = Need1;
+        table[AfterED][Cont80] = table[AfterED][Cont90] = Need1;
+        table[AfterF0][Cont90] = table[AfterF0][ContA0] = Need2;
+        table[AfterF4][Cont80] = Need2;
+        return table;
+    }();
+
+    static constexpr bool isSpace(unsigned char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+public:
+    // TrackBlank = false sare peste cautarea unui caracter care nu e spatiu (regula il permite oricum)
+    template <bool TrackBlank = true>
+    static TextScan scan(string_view text)
+    {
+        TextScan result;
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(text.data());
+        size_t size = text.size(), i = 0, continuations = 0;
+        uint8_t state = Accept;
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i belowContinuation = _mm_set1_epi8(-64); // octetii 80..BF sunt < -64 cu semn
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i beforeTab = _mm_set1_epi8('\t' - 1);
+        const __m128i afterReturn = _mm_set1_epi8('\r' + 1);
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+            int high = _mm_movemask_epi8(bytes);
+            if (high == 0 && state == Accept)
+            {
+                if (TrackBlank && result.blank)
+                {
+                    __m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(bytes, space),
+                                                  _mm_and_si128(_mm_cmpgt_epi8(bytes, beforeTab), _mm_cmplt_epi8(bytes, afterReturn)));
+                    result.blank = _mm_movemask_epi8(spaces) == 0xFFFF;
+                }
+                continue;
+            }
+            result.blank = false;
+            continuations += popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmplt_epi8(bytes, belowContinuation))));
+            // automatul trece doar prin octetii peste 7F; un octet ASCII e corect doar intre secvente
+            size_t next = i;
+            for (unsigned rest = static_cast<unsigned>(high); rest != 0; rest &= rest - 1)
+            {
+                size_t j = i + countr_zero(rest);
+                if (j != next && state != Accept)
+                    state = Reject;
+                state = transitions[state][classes[p[j]]];
+                next = j + 1;
+            }
+            if (next != i + 16 && state != Accept)
+                state = Reject;
+            if (state == Reject)
+            {
+                result.valid = false;
+                return result;
+            }
+        }
+#endif
+        for (; i < size; i++)
+        {
+            unsigned char c = p[i];
+            continuations += (c & 0xC0) == 0x80;
+            if (TrackBlank && result.blank && !isSpace(c))
+                result.blank = false;
+            state = transitions[state][classes[c]];
+        }
+        result.valid = state == Accept;
+        result.codePoints = size - continuations;
+        return result;
+    }
+};
+
+// Limitele unui text introdus, in caractere: "ă" sau "ș" conteaza ca un caracter, nu ca doi octeti
+struct TextRule
+{
+    uint32_t minLength = 1;
+    uint32_t maxLength = numeric_limits<uint32_t>::max();
+    bool blankAllowed = false; // textul poate fi format doar din spatii
+};
+
+// Regulile tuturor textelor cerute de pasi
+struct InputRules
+{
+    static constexpr TextRule title{2, 50};
+    static constexpr TextRule text{2, 100};
+    static constexpr TextRule textInput{2, 50};
+    static constexpr TextRule description{2, 200};
+    static constexpr TextRule numberDescription{2, 200, true};
+    static constexpr TextRule fileDescription{2, 500, true};
+    static constexpr TextRule outputName{1};
+    static constexpr TextRule outputTitle{2, 50, true};
+    static constexpr TextRule outputDescription{5, 300, true};
+    static constexpr TextRule flowName{1};
+};
+
+// Verificarea unui text dupa o regula fixata la compilare
+template <TextRule Rule>
+struct ValidText
+{
+    static_assert(Rule.minLength <= Rule.maxLength, "minLength must not exceed maxLength");
+
+    static bool check(string_view text)
+    {
+        // un caracter are intre 1 si 4 octeti, deci unele texte sunt respinse fara sa fie citite
+        if (text.size() < Rule.minLength || text.size() > 4ull * Rule.maxLength)
+            return false;
+        TextScan scan = Utf8::scan<!Rule.blankAllowed>(text);
+        return scan.valid && scan.codePoints >= Rule.minLength && scan.codePoints <= Rule.maxLength && (Rule.blankAllowed || !scan.blank);
+    }
+};
+
+// Ce s-a intamplat cu un pas intr-o singura rulare. Definitia pasului (FlowStep) nu se modifica la rulare,
+// asa ca aceeasi definitie poate fi folosita de oricate rulari in acelasi timp.
+struct StepState
+{
+    bool executed = false;
+    bool skipped = false;
+    int errors = 0;
+    string failure; // de ce a esuat lucrarea din fundal (StepGraph); gol daca a reusit
+
+    StepState(pmr::memory_resource * = nullptr) {}
+    virtual ~StepState() = default;
+};
+
+class FlowRun;
+
+class FlowStep
+{
+protected:
+    string name;
+    string description;
+
+    template <typename State>
+    static StepState *allocate(pmr::memory_resource &arena)
+    {
+        return new (arena.allocate(sizeof(State), alignof(State))) State(&arena);
+    }
+
+public:
+    FlowStep(string Name, string Description) : name(Name), description(Description) {}
+
+    const string &getName() const
+    {
+        return name;
+    }
+    const string &getDescription() const
+    {
+        return description;
+    }
+
+    virtual StepKind kind() const = 0;
+
+    // Starea unei executii este construita in memoria rularii (RunArena)
+    virtual StepState *createState(pmr::memory_resource &arena) const
+    {
+        return allocate<StepState>(arena);
+    }
+
+    // Datele culese la rulare, pentru snapshot
+    virtual void saveState(const StepState &state, SnapshotWriter &w) const
+    {
+        w.putBool(state.executed);
+        w.putBool(state.skipped);
+        w.putI32(state.errors);
+    }
+    virtual void loadState(StepState &state, SnapshotReader &r) const
+    {
+        state.executed = r.getBool();
+        state.skipped = r.getBool();
+        state.errors = r.getI32();
+    }
+
+    virtual Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const = 0;
+
+    // Ce se reia cand utilizatorul alege "Reload the Step" dupa o eroare
+    virtual Task<> reload(StepState &state, FlowIO &io, const FlowRun &run) const
+    {
+        co_await execute(state, io, run);
+    }
+
+    virtual void displayDetails(FlowIO &io) const
+    {
+        io.out << endl;
+        io.out << "Step name: " << name << "\n";
+        io.out << "Description: " << description << "\n";
+    }
+
+    virtual bool validateInput(string_view input) const { return true; }
+
+    virtual string extractInfo(const StepState &state) const { return " "; }
+
+    // Aceeasi informatie ca extractInfo, trimisa pe bucati; pasii care citesc fisiere nu o tin toata in memorie
+    virtual void streamInfo(const StepState &state, ChunkPipe &pipe) const
+    {
+        pipe.write(extractInfo(state));
+    }
+
+    // Functie care ii da utilizatorului posibilitatea de a da skip unei etape
+    virtual Task<bool> Skip(StepState &state, FlowIO &io) const
+    {
+        string input;
+        io.out << "Write yes if you want to skip this step or no if you don't want to skip this step: " << endl;
+        while (true)
+        {
+            co_await io.line(input);
+            if (input.find_first_not_of(' ') == string::npos)
+            {
+                io.out << "Input should not be empty. Try again: "; // pt cand apasa doar enter
+            }
+            else if (input == "yes")
+            {
+                io.out << "Step skipped." << endl;
+                state.skipped = true;
+                co_return true;
+            }
+            else if (input == "no")
+            {
+                co_return false;
+            }
+            else
+            {
+                io.out << "Invalid input. Try again: ";
+            }
+        }
+    }
+
+    virtual void displayProgress(const StepState &state, FlowIO &io) const {}
+
+    // Partea fara interactiune a unei executii, rulata pe alt fir dupa execute (vezi StepGraph).
+    // inputs adauga starile ale caror lucrari trebuie terminate inainte.
+    virtual bool hasWork(const StepState &state) const { return false; }
+    virtual void inputs(const StepState &state, vector<const StepState *> &after) const {}
+    virtual void work(StepState &state) const {}
+
+    Task<> ifError(const invalid_argument &e, StepState &state, FlowIO &io, const FlowRun &run) const
+    {
+        int c;
+        io.out << "Error: " << e.what() << endl;
+        io.out << "Choose if you want to reload the step or go to the next one " << endl;
+        io.out << "\t|    Press 1 to Reload the Step                 |" << endl;
+        io.out << "\t|    Press 2 to Go to the next Step             |" << endl;
+        co_await io.token(c);
+        switch (c)
+        {
+        case 1:
+            io.ignore();
+            co_await reload(state, io, run);
+            break;
+        case 2:
+            io.ignore();
+            state.skipped = true;
+            break;
+        default:
+            if (io.interactive)
+                system("cls");
+            io.out << "\t\t\t Please select from the options given above \n"
+                   << endl;
+        }
+    }
+
+    virtual ~FlowStep() = default;
+};
+
+// Partea fara interactiune a pasilor unei rulari (incarcari de fisiere, calcule, scrierea iesirii).
+// Fiecare lucrare porneste pe un fir din pool imediat ce s-au terminat lucrarile de care depinde, asa ca
+// rularea dureaza cat cel mai lung lant de dependente, nu cat suma pasilor. Intrebarile raman in ordine.
+class StepGraph
+{
+private:
+    struct Node
+    {
+        StepState *state = nullptr;
+        function<void()> work;
+        vector<Node *> dependents{};
+        vector<function<void()>> whenDone{}; // anunturile celor care asteapta fara sa blocheze (sesiuni)
+        size_t waitingFor = 0;
+        bool started = false, done = false;
+    };
+
+    // Sarcinile din pool tin nodurile in viata: un nod rulat deja de firul care astepta
+    // poate fi verificat de pool si dupa ce rularea s-a terminat
+    struct Nodes : enable_shared_from_this<Nodes>
+    {
+        mutex lock;
+        condition_variable finished;
+        deque<Node> list;
+        size_t unfinished = 0;
+        vector<function<void()>> whenIdle;
+    };
+    shared_ptr<Nodes> nodes; // creat la prima lucrare; rularile fara lucrari nu il aloca
+    bool background = true;  // false: lucrarile ruleaza pe firul rularii, cand e nevoie de ele
+
+    static WorkerPool &workers()
+    {
+        static WorkerPool pool(max(2u, thread::hardware_concurrency()));
+        return pool;
+    }
+
+    static void run(Nodes &nodes, Node &node, bool background)
+    {
+        // o lucrare care arunca lasa eroarea in starea ei; cine o asteapta o vede dupa ready()/await()
+        try
+        {
+            node.work();
+        }
+        catch (const exception &e)
+        {
+            node.state->failure = e.what();
+        }
+        catch (...)
+        {
+            node.state->failure = "unknown error";
+        }
+        if (!node.state->failure.empty())
+        {
+            node.state->errors++;
+            Log::error("Step work failed: " + node.state->failure);
+        }
+        vector<Node *> ready;
+        vector<function<void()>> notify;
+        {
+            lock_guard<mutex> guard(nodes.lock);
+            node.done = true;
+            nodes.unfinished--;
+            for (Node *next : node.dependents)
+            {
+                if (--next->waitingFor == 0)
+                    ready.push_back(next);
+            }
+            notify = move(node.whenDone);
+            if (nodes.unfinished == 0)
+            {
+                notify.insert(notify.end(), make_move_iterator(nodes.whenIdle.begin()), make_move_iterator(nodes.whenIdle.end()));
+                nodes.whenIdle.clear();
+            }
+            nodes.finished.notify_all();
+        }
+        for (auto &done : notify)
+            done();
+        if (background)
+        {
+            for (Node *next : ready)
+                start(nodes, *next);
+        }
+    }
+
+    // Nodul e rulat de primul care il ia: un fir din pool sau firul care asteapta dupa el
+    static void start(Nodes &nodes, Node &node)
+    {
+        workers().post([owner = nodes.shared_from_this(), &node]
+                         {
+                             {
+                                 lock_guard<mutex> guard(owner->lock);
+                                 if (node.started)
+                                     return;
+                                 node.started = true;
+                             }
+                             run(*owner, node, true); });
+    }
+
+    // Se apeleaza cu lock luat; intoarce un nod gata de pornire pe care nu l-a luat inca nimeni
+    Node *unclaimed()
+    {
+        for (auto &node : nodes->list)
+        {
+            if (!node.started && node.waitingFor == 0)
+            {
+                node.started = true;
+                return &node;
+            }
+        }
+        return nullptr;
+    }
+
+public:
+    StepGraph() = default;
+    StepGraph(const StepGraph &) = delete;
+
+    // Rularile fara utilizator sunt deja paralele intre ele (FlowManager::runBatch), asa ca isi ruleaza
+    // lucrarile pe firul propriu, fara drumul pana la pool
+    void runInBackground(bool enabled)
+    {
+        background = enabled;
+    }
+    StepGraph &operator=(const StepGraph &) = delete;
+
+    // work porneste dupa ce s-au terminat lucrarile starilor din after
+    void add(StepState *state, function<void()> work, const vector<const StepState *> &after)
+    {
+        if (!nodes)
+            nodes = make_shared<Nodes>();
+        Node *node;
+        {
+            lock_guard<mutex> guard(nodes->lock);
+            node = &nodes->list.emplace_back(Node{state, move(work)});
+            nodes->unfinished++;
+            for (auto &other : nodes->list)
+            {
+                if (!other.done && &other != node && find(after.begin(), after.end(), other.state) != after.end())
+                {
+                    other.dependents.push_back(node);
+                    node->waitingFor++;
+                }
+            }
+            if (node->waitingFor != 0 || !background)
+                return;
+        }
+        start(*nodes, *node);
+    }
+
+    // Asteapta lucrarea unei stari (sau toate, pentru nullptr). In loc sa stea, firul care asteapta
+    // ruleaza el lucrarile gata de pornire.
+    void wait(const StepState *state)
+    {
+        if (!nodes)
+            return;
+        auto pending = [&]
+        {
+            if (state == nullptr)
+                return nodes->unfinished != 0;
+            return any_of(nodes->list.begin(), nodes->list.end(), [&](const Node &node)
+                          { return node.state == state && !node.done; });
+        };
+        unique_lock<mutex> guard(nodes->lock);
+        while (pending())
+        {
+            if (Node *node = unclaimed())
+            {
+                guard.unlock();
+                run(*nodes, *node, background);
+                guard.lock();
+            }
+            else
+                nodes->finished.wait(guard);
+        }
+    }
+
+    void waitAll()
+    {
+        wait(nullptr);
+    }
+
+    // Ca wait, fara sa blocheze: done ruleaza cand lucrarea e gata, pe firul care o termina,
+    // sau imediat daca nu mai e nimic de asteptat
+    void whenDone(const StepState *state, function<void()> done)
+    {
+        if (nodes && !background)
+            wait(state);
+        if (nodes && background)
+        {
+            lock_guard<mutex> guard(nodes->lock);
+            if (state == nullptr && nodes->unfinished != 0)
+            {
+                nodes->whenIdle.push_back(move(done));
+                return;
+            }
+            for (auto &node : nodes->list)
+            {
+                if (state != nullptr && node.state == state && !node.done)
+                {
+                    node.whenDone.push_back(move(done));
+                    return;
+                }
+            }
+        }
+        done();
+    }
+
+    ~StepGraph()
+    {
+        waitAll();
+    }
+};
+
+struct StepRun
+{
+    const FlowStep *step;
+    StepState *state;
+};
+
+// Memoria unei rulari: starile pasilor, textele lor si listele rularii sunt luate in ordine
+// dintr-un bloc (primii 4 KB sunt chiar in obiect) si sunt eliberate toate o data cu rularea.
+// Lucrarile pasilor (StepGraph) aloca si ele de aici, de pe alte fire, deci alocarea e sub lock.
+class RunArena : public pmr::memory_resource
+{
+private:
+    alignas(max_align_t) char initial[4096];
+    pmr::monotonic_buffer_resource blocks{initial, sizeof(initial)};
+    size_t used = 0;
+    mutex lock;
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        lock_guard<mutex> guard(lock);
+        used += bytes;
+        return blocks.allocate(bytes, alignment);
+    }
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+public:
+    RunArena() = default;
+    RunArena(const RunArena &) = delete;
+    RunArena &operator=(const RunArena &) = delete;
+
+    size_t bytesInUse() const
+    {
+        return used;
+    }
+};
+
+// Starea unei rulari a unui flow. Fiecare executie a unui pas primeste starea ei,
+// deci un pas adaugat "one more time" nu mai suprascrie rezultatele executiei anterioare.
+class FlowRun
+{
+private:
+    struct Storage
+    {
+        RunArena arena;
+        pmr::vector<StepRun> executions{&arena}; // toate executiile, si cele sarite
+        pmr::vector<size_t> order{&arena};       // executiile care fac parte din flow, in ordine, si cu pasii repetati
+        StepGraph graph;
+    };
+    unique_ptr<Storage> storage; // creat la prima executie, ca o rulare goala sa nu ocupe memorie
+
+    void release()
+    {
+        if (storage)
+        {
+            storage->graph.waitAll();
+            for (auto &execution : storage->executions)
+                execution.state->~StepState();
+        }
+        storage.reset();
+    }
+
+public:
+    FlowRun() = default;
+    FlowRun(FlowRun &&other) = default;
+    FlowRun &operator=(FlowRun &&other)
+    {
+        if (this != &other)
+        {
+            release();
+            storage = move(other.storage);
+        }
+        return *this;
+    }
+    ~FlowRun()
+    {
+        release();
+    }
+
+    size_t add(const FlowStep &step)
+    {
+        if (!storage)
+            storage = make_unique<Storage>();
+        storage->executions.push_back({&step, step.createState(storage->arena)});
+        return storage->executions.size() - 1;
+    }
+
+    StepState &state(size_t execution)
+    {
+        return *storage->executions[execution].state;
+    }
+
+    void include(size_t execution)
+    {
+        storage->order.push_back(execution);
+    }
+
+    void runStepsInBackground(bool enabled)
+    {
+        if (!storage)
+            storage = make_unique<Storage>();
+        storage->graph.runInBackground(enabled);
+    }
+
+    // Porneste lucrarea executiei, daca are una, dupa lucrarile de care depinde
+    void schedule(size_t execution)
+    {
+        StepRun run = storage->executions[execution];
+        if (!run.step->hasWork(*run.state))
+            return;
+        vector<const StepState *> after;
+        run.step->inputs(*run.state, after);
+        storage->graph.add(run.state, [run]
+                           {
+                               auto start = chrono::steady_clock::now();
+                               run.step->work(*run.state);
+                               Metrics::shared().recordStep(run.step->kind(), Metrics::Work, chrono::steady_clock::now() - start); }, after);
+    }
+
+    // Un pas care foloseste rezultatul altei executii asteapta intai lucrarea ei; false daca lucrarea a esuat
+    bool await(const StepState *state) const
+    {
+        if (storage)
+            storage->graph.wait(state);
+        return state == nullptr || state->failure.empty();
+    }
+
+    void finish()
+    {
+        if (storage)
+            storage->graph.waitAll();
+    }
+
+    // co_await run.ready(state, io): ca await, dar intr-o sesiune corutina se suspenda in loc sa blocheze
+    // bucla si e reluata de ea cand lucrarea e gata (nullptr: toate lucrarile rularii)
+    struct Ready
+    {
+        const FlowRun &run;
+        const StepState *state;
+        EventLoop *loop;
+
+        bool await_ready() const { return loop == nullptr || !run.storage; }
+        void await_suspend(coroutine_handle<> waiting)
+        {
+            run.storage->graph.whenDone(state, [loop = loop, waiting]
+                                        { loop->resume(waiting); });
+        }
+        bool await_resume()
+        {
+            return run.await(state);
+        }
+    };
+    Ready ready(const StepState *state, FlowIO &io) const
+    {
+        return {*this, state, io.loop};
+    }
+
+    // Ultima executie a unui pas in aceasta rulare, sau nullptr daca pasul nu a rulat
+    const StepState *latest(const FlowStep *step) const
+    {
+        if (!storage)
+            return nullptr;
+        for (auto it = storage->executions.rbegin(); it != storage->executions.rend(); ++it)
+        {
+            if (it->step == step)
+                return it->state;
+        }
+        return nullptr;
+    }
+
+    size_t size() const
+    {
+        return storage ? storage->order.size() : 0;
+    }
+
+    const StepRun &operator[](size_t i) const
+    {
+        return storage->executions[storage->order[i]];
+    }
+
+    size_t bytesInUse() const
+    {
+        return storage ? storage->arena.bytesInUse() : 0;
+    }
+
+    int totalErrors() const
+    {
+        int total = 0;
+        if (storage)
+        {
+            for (auto &execution : storage->executions)
+                total += execution.state->errors;
+        }
+        return total;
+    }
+
+    int skippedCount() const
+    {
+        int total = 0;
+        if (storage)
+        {
+            for (auto &execution : storage->executions)
+                total += execution.state->skipped ? 1 : 0;
+        }
+        return total;
+    }
+
+    // Pasii sunt scrisi prin pozitia lor in definitia flow-ului (stepIndex)
+    template <typename IndexOf>
+    void save(SnapshotWriter &w, IndexOf stepIndex) const
+    {
+        if (!storage)
+        {
+            w.putU32(0);
+            w.putU32(0);
+            return;
+        }
+        w.putU32(static_cast<uint32_t>(storage->executions.size()));
+        for (auto &execution : storage->executions)
+        {
+            w.putU32(stepIndex(execution.step));
+            w.putU8(static_cast<uint8_t>(execution.step->kind()));
+            execution.step->saveState(*execution.state, w);
+        }
+        w.putU32(static_cast<uint32_t>(storage->order.size()));
+        for (auto &execution : storage->order)
+            w.putU32(static_cast<uint32_t>(execution));
+    }
+
+    template <typename StepAt>
+    static FlowRun load(SnapshotReader &r, StepAt stepAt)
+    {
+        FlowRun run;
+        uint32_t count = r.getU32();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const FlowStep *step = stepAt(r.getU32());
+            if (step == nullptr || static_cast<uint8_t>(step->kind()) != r.getU8())
+                throw runtime_error("Corrupt flow snapshot.");
+            StepState &state = run.state(run.add(*step));
+            step->loadState(state, r);
+        }
+        uint32_t orderCount = r.getU32();
+        for (uint32_t i = 0; i < orderCount; i++)
+        {
+            uint32_t execution = r.getU32();
+            if (execution >= count)
+                throw runtime_error("Corrupt flow snapshot.");
+            run.include(execution);
+        }
+        return run;
+    }
+};
+
+class TitleStep : public FlowStep
+{
+public:
+    struct State : StepState
+    {
+        pmr::string title, subtitle;
+
+        State(pmr::memory_resource *arena) : title(arena), subtitle(arena) {}
+    };
+
+    TitleStep(string name, string description) : FlowStep(name, description) {}
+
+    StepKind kind() const override { return StepKind::Title; }
+
+    StepState *createState(pmr::memory_resource &arena) const override { return allocate<State>(arena); }
+
+    void saveState(const StepState &state, SnapshotWriter &w) const override
+    {
+        FlowStep::saveState(state, w);
+        const State &data = static_cast<const State &>(state);
+        w.putString(data.title);
+        w.putString(data.subtitle);
+    }
+    void loadState(StepState &state, SnapshotReader &r) const override
+    {
+        FlowStep::loadState(state, r);
+        State &data = static_cast<State &>(state);
+        data.title = r.getString();
+        data.subtitle = r.getString();
+    }
+
+    bool validateInput(string_view input) const override
+    {
+        return ValidText<InputRules::title>::check(input);
+    }
+
+    Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        State &data = static_cast<State &>(state);
+        displayDetails(io);
+        if (co_await Skip(state, io))
+        {
+            co_return;
+        }
+        else
+        {
+            optional<invalid_argument> failure;
+            try
+            {
+                io.out << "\tEnter the title : " << endl;
+                co_await io.line(data.title);
+                if (validateInput(data.title) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid title. Title cannot be empty and must have between 2 and 50 characters.");
+                }
+                io.out << "\tEnter the subtitle : " << endl;
+                co_await io.line(data.subtitle);
+                if (validateInput(data.subtitle) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid subtitle. Subtitle cannot be empty and must have between 2 and 50 characters.");
+                }
+
+                data.executed = true;
+            }
+            catch (const invalid_argument &e)
+            {
+                data.title = "";
+                data.subtitle = "";
+                failure = e;
+            }
+            if (failure)
+                co_await ifError(*failure, state, io, run);
+        }
+    }
+
+    void displayProgress(const StepState &state, FlowIO &io) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        time_t now = time(nullptr);
+        if (data.title.empty() && data.subtitle.empty())
+        {
+            return;
+        }
+        io.out << "TitleStep completed with title: " << data.title << " and subtitle: " << data.subtitle << endl;
+        io.out << "Number of error screens displayed: " << data.errors << endl;
+        io.out << "Completion time: " << timeText(now) << endl;
+    }
+
+    string extractInfo(const StepState &state) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.title.empty() && data.subtitle.empty())
+        {
+            return "Title and subtitle are empty.";
+        }
+        return string(data.title) + " " + string(data.subtitle);
+    }
+};
+
+class TextStep : public FlowStep
+{
+public:
+    struct State : StepState
+    {
+        pmr::string title, copy;
+
+        State(pmr::memory_resource *arena) : title(arena), copy(arena) {}
+    };
+
+    TextStep(string name, string description) : FlowStep(name, description) {}
+
+    StepKind kind() const override { return StepKind::Text; }
+
+    StepState *createState(pmr::memory_resource &arena) const override { return allocate<State>(arena); }
+
+    void saveState(const StepState &state, SnapshotWriter &w) const override
+    {
+        FlowStep::saveState(state, w);
+        const State &data = static_cast<const State &>(state);
+        w.putString(data.title);
+        w.putString(data.copy);
+    }
+    void loadState(StepState &state, SnapshotReader &r) const override
+    {
+        FlowStep::loadState(state, r);
+        State &data = static_cast<State &>(state);
+        data.title = r.getString();
+        data.copy = r.getString();
+    }
+
+    Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        State &data = static_cast<State &>(state);
+        displayDetails(io);
+        if (co_await Skip(state, io))
+        {
+            co_return;
+        }
+        else
+        {
+            optional<invalid_argument> failure;
+            try
+            {
+
+                io.out << "\tEnter the title : " << endl;
+                co_await io.line(data.title);
+                if (ValidText<InputRules::title>::check(data.title) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid title. Title cannot be empty and must have between 2 and 50 characters.");
+                }
+
+                io.out << "\tEnter text : " << endl;
+                co_await io.line(data.copy);
+                if (ValidText<InputRules::text>::check(data.copy) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid text. Text cannot be empty and must have between 2 and 100 characters.");
+                }
+                data.executed = true;
+            }
+            catch (const invalid_argument &e)
+            {
+                data.title = "";
+                data.copy = "";
+                failure = e;
+            }
+            if (failure)
+                co_await ifError(*failure, state, io, run);
+        }
+    }
+
+    string extractInfo(const StepState &state) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.title.empty() && data.copy.empty())
+        {
+            return "Title and copy are empty.";
+        }
+        return string(data.title) + "\n" + string(data.copy);
+    }
+
+    void displayProgress(const StepState &state, FlowIO &io) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.title.empty() && data.copy.empty())
+        {
+            return;
+        }
+        time_t now = time(nullptr);
+        io.out << "TextStep completed with title: " << data.title << " and copy: " << data.copy << endl;
+        io.out << "Number of error screens displayed: " << data.errors << endl;
+        io.out << "Completion time: " << timeText(now) << endl;
+    }
+};
+
+class TextInputStep : public FlowStep
+{
+public:
+    struct State : StepState
+    {
+        pmr::string desc, text_input;
+
+        State(pmr::memory_resource *arena) : desc(arena), text_input(arena) {}
+    };
+
+    TextInputStep(string name, string description) : FlowStep(name, description) {}
+
+    StepKind kind() const override { return StepKind::TextInput; }
+
+    StepState *createState(pmr::memory_resource &arena) const override { return allocate<State>(arena); }
+
+    void saveState(const StepState &state, SnapshotWriter &w) const override
+    {
+        FlowStep::saveState(state, w);
+        const State &data = static_cast<const State &>(state);
+        w.putString(data.desc);
+        w.putString(data.text_input);
+    }
+    void loadState(StepState &state, SnapshotReader &r) const override
+    {
+        FlowStep::loadState(state, r);
+        State &data = static_cast<State &>(state);
+        data.desc = r.getString();
+        data.text_input = r.getString();
+    }
+
+    Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        State &data = static_cast<State &>(state);
+        displayDetails(io);
+        if (co_await Skip(state, io))
+        {
+            co_return;
+        }
+        else
+        {
+            optional<invalid_argument> failure;
+            try
+            {
+                io.out << "\tEnter text : " << endl;
+                co_await io.line(data.text_input);
+                if (ValidText<InputRules::textInput>::check(data.text_input) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid text. Text cannot be empty and must have between 2 and 50 characters.");
+                }
+                io.out << "\tEnter description : " << endl;
+                co_await io.line(data.desc);
+                if (ValidText<InputRules::description>::check(data.desc) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid description. Description cannot be empty and must have between 2 and 200 characters.");
+                }
+                data.executed = true;
+            }
+            catch (const invalid_argument &e)
+            {
+                data.desc = "";
+                data.text_input = "";
+                failure = e;
+            }
+            if (failure)
+                co_await ifError(*failure, state, io, run);
+        }
+    }
+
+    string extractInfo(const StepState &state) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.desc.empty() && data.text_input.empty())
+        {
+            return "Text input and description are empty.";
+        }
+        return string(data.text_input) + "\n" + string(data.desc); // sau return text_input ;
+    }
+
+    void displayProgress(const StepState &state, FlowIO &io) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.desc.empty() && data.text_input.empty())
+        {
+            return;
+        }
+        time_t now = time(nullptr);
+        io.out << "TextInputStep completed with textInput: " << data.text_input << " and description: " << data.desc << endl;
+        io.out << "Number of error screens displayed: " << data.errors << endl;
+        io.out << "Completion time: " << timeText(now) << endl;
+    }
+};
+
+class NumberInputStep : public FlowStep
+{
+public:
+    struct State : StepState
+    {
+        pmr::string desc;
+        float number = 0; // primul numar, daca s-au introdus mai multe
+        // Mai multe numere pe aceeasi linie sau dintr-un fisier (file:<nume>)
+        pmr::string source;               // numele fisierului, gol pentru numerele scrise in raspuns
+        uint64_t count = 0;
+        shared_ptr<const NumberList> list; // doar pentru count > 1; nu se salveaza in snapshot
+
+        State(pmr::memory_resource *arena) : desc(arena), source(arena) {}
+    };
+
+    NumberInputStep(string name, string description) : FlowStep(name, description) {}
+
+    StepKind kind() const override { return StepKind::NumberInput; }
+
+    StepState *createState(pmr::memory_resource &arena) const override { return allocate<State>(arena); }
+
+    void saveState(const StepState &state, SnapshotWriter &w) const override
+    {
+        FlowStep::saveState(state, w);
+        const State &data = static_cast<const State &>(state);
+        w.putString(data.desc);
+        w.putFloat(data.number);
+        w.putString(data.source);
+        w.putU64(data.count);
+    }
+    void loadState(StepState &state, SnapshotReader &r) const override
+    {
+        FlowStep::loadState(state, r);
+        State &data = static_cast<State &>(state);
+        data.desc = r.getString();
+        data.number = r.getFloat();
+        data.source = r.getString();
+        data.count = r.getU64();
+    }
+
+    bool validateInput(string_view input) const override
+    {
+        return ValidText<InputRules::numberDescription>::check(input);
+    }
+
+    // Raspunsul este un numar, mai multe numere sau file:<nume>
+    void readNumbers(State &data, const string &input) const
+    {
+        shared_ptr<const NumberList> list;
+        if (input.compare(0, 5, "file:") == 0)
+        {
+            size_t start = input.find_first_not_of(' ', 5);
+            data.source = start == string::npos ? "" : input.substr(start);
+            string error;
+            list = NumberList::cached(string(data.source), error);
+            if (list == nullptr)
+            {
+                data.errors++;
+                throw invalid_argument(error);
+            }
+        }
+        else
+            list = NumberList::parse(input);
+        if (list->failed)
+        {
+            data.errors++;
+            throw invalid_argument("Invalid number at " + list->describeError() + ".");
+        }
+        if (list->values.empty())
+        {
+            data.errors++;
+            throw invalid_argument("Invalid number.");
+        }
+        data.number = static_cast<float>(list->values.front());
+        data.count = list->values.size();
+        if (data.count > 1)
+            data.list = list;
+    }
+
+    Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        State &data = static_cast<State &>(state);
+        displayDetails(io);
+        if (co_await Skip(state, io))
+        {
+            co_return;
+        }
+        else
+        {
+            optional<invalid_argument> failure;
+            try
+            {
+                string input;
+                io.out << "\tEnter number (several numbers separated by spaces, or file:<name> to read them from a file):  " << endl;
+                co_await io.line(input);
+                readNumbers(data, input);
+
+                io.out << "\tEnter description : " << endl;
+                co_await io.line(data.desc);
+                if (validateInput(data.desc) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid description. Description cannot be empty and must have between 2 and 200 characters.");
+                }
+                data.executed = true;
+            }
+            catch (const invalid_argument &e)
+            {
+                data.desc = "";
+                data.number = 0;
+                data.source = "";
+                data.count = 0;
+                data.list.reset();
+                failure = e;
+            }
+            if (failure)
+                co_await ifError(*failure, state, io, run);
+        }
+    }
+
+    string extractInfo(const StepState &state) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.desc.empty() && data.number == 0)
+        {
+            return "Title and subtitle are empty.";
+        }
+        if (data.list == nullptr)
+            return to_string(data.number);
+        string text;
+        char number[32];
+        for (double value : data.list->values)
+        {
+            text.append(number, to_chars(number, number + sizeof(number), value).ptr);
+            text += '\n';
+        }
+        return text;
+    }
+
+    // O lista lunga de numere e scrisa direct in bucatile pipe-ului, fara textul intreg in memorie
+    void streamInfo(const StepState &state, ChunkPipe &pipe) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.list == nullptr)
+        {
+            pipe.write(extractInfo(state));
+            return;
+        }
+        for (double value : data.list->values)
+        {
+            if (pipe.available() < 32) // cel mai lung double scris de to_chars are 24 de caractere
+                pipe.flush();
+            char *at = pipe.acquire();
+            char *end = to_chars(at, at + pipe.available() - 1, value).ptr;
+            *end++ = '\n';
+            pipe.commit(end - at);
+        }
+    }
+
+    void displayProgress(const StepState &state, FlowIO &io) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.desc.empty() && data.number == 0)
+        {
+            return;
+        }
+        time_t now = time(nullptr);
+        if (data.count > 1)
+            io.out << "NumberInputStep completed with " << data.count << " numbers" << (data.source.empty() ? "" : " from " + string(data.source)) << ", the first is " << data.number << ", and input description: " << data.desc << endl;
+        else
+            io.out << "NumberInputStep completed with input number: " << data.number << " and input description: " << data.desc << endl;
+        io.out << "Number of error screens displayed: " << data.errors << endl;
+        io.out << "Completion time: " << timeText(now) << endl;
+    }
+};
+
+class CalculusStep : public FlowStep
+{
+public:
+    // Rezultatul calculului pe coloane; impartit intre rularile cu aceleasi intrari (WorkCache)
+    struct Column
+    {
+        vector<double> values;
+        uint64_t divisionsByZero = 0;
+    };
+
+private:
+    NumberInputStep number1{"First Number Input Step", "Description for first number"};
+    NumberInputStep number2{"Second Number Input Step", "Description for second number"};
+
+public:
+    struct State : StepState
+    {
+        NumberInputStep::State first, second;
+        pmr::string operation;
+        float result = 0.0f;
+        // Calcul pe coloanele unui fisier csv: fiecare operand e un nume de coloana sau un numar
+        bool columns = false;
+        pmr::string fileName, firstOperand, secondOperand;
+        shared_ptr<const Column> column; // nu se salveaza in snapshot, doar numarul de randuri
+        uint64_t rows = 0, divisionsByZero = 0;
+        pmr::string expression; // calcul cu o expresie peste numerele introduse mai devreme in rulare
+        pmr::string problem;    // de ce nu s-a putut calcula coloana
+
+        State(pmr::memory_resource *arena) : first(arena), second(arena), operation(arena), fileName(arena), firstOperand(arena), secondOperand(arena), expression(arena), problem(arena) {}
+    };
+
+    CalculusStep(string name, string description) : FlowStep(name, description) {}
+
+    StepKind kind() const override { return StepKind::Calculus; }
+
+    StepState *createState(pmr::memory_resource &arena) const override { return allocate<State>(arena); }
+
+    void saveState(const StepState &state, SnapshotWriter &w) const override
+    {
+        FlowStep::saveState(state, w);
+        const State &data = static_cast<const State &>(state);
+        number1.saveState(data.first, w);
+        number2.saveState(data.second, w);
+        w.putString(data.operation);
+        w.putFloat(data.result);
+        w.putBool(data.columns);
+        w.putString(data.fileName);
+        w.putString(data.firstOperand);
+        w.putString(data.secondOperand);
+        w.putU64(data.rows);
+        w.putU64(data.divisionsByZero);
+        w.putString(data.expression);
+        w.putString(data.problem);
+    }
+    void loadState(StepState &state, SnapshotReader &r) const override
+    {
+        FlowStep::loadState(state, r);
+        State &data = static_cast<State &>(state);
+        number1.loadState(data.first, r);
+        number2.loadState(data.second, r);
+        data.operation = r.getString();
+        data.result = r.getFloat();
+        data.columns = r.getBool();
+        data.fileName = r.getString();
+        data.firstOperand = r.getString();
+        data.secondOperand = r.getString();
+        data.rows = r.getU64();
+        data.divisionsByZero = r.getU64();
+        data.expression = r.getString();
+        data.problem = r.getString();
+    }
+
+    Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        State &data = static_cast<State &>(state);
+        displayDetails(io);
+        if (co_await Skip(state, io))
+        {
+            co_return;
+        }
+        else
+        {
+            optional<invalid_argument> failure;
+            try
+            {
+                string mode;
+                io.out << "Calculate with numbers, csv columns or an expression? (numbers / columns / expression): ";
+                co_await io.token(mode);
+                io.ignore();
+                if (mode == "columns")
+                {
+                    co_await calculateColumns(data, io);
+                    co_return;
+                }
+                if (mode == "expression")
+                {
+                    co_await calculateExpression(data, io, run);
+                    co_return;
+                }
+                if (mode != "numbers")
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid calculation mode.");
+                }
+                io.out << "First number: " << endl;
+                co_await number1.execute(data.first, io, run);
+                io.out << "Second number: " << endl;
+                co_await number2.execute(data.second, io, run);
+
+                io.out << "Enter operation (+, -, *, /, min, max): ";
+                co_await io.token(data.operation);
+
+                if (data.operation == "+")
+                {
+                    data.result = data.first.number + data.second.number;
+                }
+                else if (data.operation == "-")
+                {
+                    data.result = data.first.number - data.second.number;
+                }
+                else if (data.operation == "*")
+                {
+                    data.result = data.first.number * data.second.number;
+                }
+                else if (data.operation == "/")
+                {
+                    if (data.second.number != 0)
+                    {
+                        data.result = data.first.number / data.second.number;
+                    }
+                    else
+                    {
+                        data.errors++;
+                        throw invalid_argument("Division by zero is not allowed.");
+                    }
+                }
+                else if (data.operation == "min")
+                {
+                    data.result = min(data.first.number, data.second.number);
+                }
+                else if (data.operation == "max")
+                {
+                    data.result = max(data.first.number, data.second.number);
+                }
+                else
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid operation.");
+                }
+                io.out << "Result of operation: " << data.result << endl;
+                io.ignore();
+            }
+            catch (const invalid_argument &e)
+            {
+                data.result = 0.0f;
+                data.first.number = 0;
+                data.second.number = 0;
+                data.first.desc = "";
+                data.second.desc = "";
+                data.columns = false;
+                data.column.reset();
+                data.rows = data.divisionsByZero = 0;
+                data.expression = "";
+                data.problem = "";
+                failure = e;
+            }
+            if (failure)
+                co_await ifError(*failure, state, io, run);
+        }
+    }
+
+    // Un nume din expresie este descrierea unui NumberInputStep din rulare (cel mai recent) sau nK, al K-lea numar introdus
+    static bool numberInRun(const FlowRun &run, string_view name, double &value)
+    {
+        vector<const NumberInputStep::State *> numbers;
+        for (size_t i = 0; i < run.size(); i++)
+        {
+            if (run[i].step->kind() == StepKind::NumberInput && !run[i].state->skipped)
+                numbers.push_back(static_cast<const NumberInputStep::State *>(run[i].state));
+        }
+        for (auto number = numbers.rbegin(); number != numbers.rend(); number++)
+        {
+            if ((*number)->desc == name)
+            {
+                value = (*number)->number;
+                return true;
+            }
+        }
+        size_t position = 0;
+        if (name.size() > 1 && name[0] == 'n' && from_chars(name.data() + 1, name.data() + name.size(), position).ptr == name.data() + name.size() &&
+            position >= 1 && position <= numbers.size())
+        {
+            value = numbers[position - 1]->number;
+            return true;
+        }
+        return false;
+    }
+
+    Task<> calculateExpression(State &data, FlowIO &io, const FlowRun &run) const
+    {
+        io.out << "\tEnter expression, using the descriptions of earlier numbers or n1, n2, ... (+, -, *, /, min(x, y), max(x, y)): " << endl;
+        co_await io.line(data.expression);
+        shared_ptr<const Expression> compiled;
+        try
+        {
+            compiled = Expression::cached(data.expression);
+        }
+        catch (const invalid_argument &)
+        {
+            data.errors++;
+            throw;
+        }
+        vector<double> values(compiled->names().size());
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            if (!numberInRun(run, compiled->names()[i], values[i]))
+            {
+                data.errors++;
+                throw invalid_argument("No number named " + compiled->names()[i] + " earlier in this run.");
+            }
+        }
+        bool divisionByZero = false;
+        double result = compiled->evaluate(values.data(), divisionByZero);
+        if (divisionByZero)
+        {
+            data.errors++;
+            throw invalid_argument("Division by zero is not allowed.");
+        }
+        data.result = static_cast<float>(result);
+        data.executed = true;
+        io.out << "Result of expression: " << data.result << endl;
+    }
+
+    // Un operand este o coloana numerica din tabel sau un numar aplicat fiecarui rand
+    static ColumnMath::Operand resolveOperand(const CsvTable &table, string_view name, vector<double> &storage)
+    {
+        if (const CsvColumn *column = table.column(name))
+        {
+            if (column->type == CsvType::Double)
+                return {column->numbers.data(), false};
+            if (column->type == CsvType::Integer)
+            {
+                storage = column->asDoubles();
+                return {storage.data(), false};
+            }
+            throw invalid_argument("Column " + string(name) + " is not numeric.");
+        }
+        double value;
+        auto [end, error] = from_chars(name.data(), name.data() + name.size(), value);
+        if (name.empty() || error != errc() || end != name.data() + name.size())
+            throw invalid_argument("Unknown column or number: " + string(name));
+        storage.assign(1, value);
+        return {storage.data(), true};
+    }
+
+    Task<> calculateColumns(State &data, FlowIO &io) const
+    {
+        io.out << "\tEnter csv file name: " << endl;
+        co_await io.line(data.fileName);
+        // Amprenta din work() se ia pe un singur fisier, deci directoarele si tiparele nu sunt acceptate aici
+        string_view plainName = InputFile::withoutCodec(data.fileName);
+        if (FileSet::isSet(string(data.fileName)) || plainName.substr(plainName.find_last_of(".") + 1) != "csv")
+        {
+            data.errors++;
+            throw invalid_argument(string(data.fileName) + " is not a single csv file. Enter one .csv file (optionally followed by .gz, .zst, .bz2 or .xz).");
+        }
+        if (!ifstream(string(data.fileName)).is_open())
+        {
+            data.errors++;
+            throw invalid_argument("Cannot open csv file " + string(data.fileName));
+        }
+        io.out << "\tFirst operand (column name or number): " << endl;
+        co_await io.line(data.firstOperand);
+        io.out << "\tSecond operand (column name or number): " << endl;
+        co_await io.line(data.secondOperand);
+        io.out << "Enter operation (+, -, *, /, min, max): ";
+        co_await io.token(data.operation);
+        CalcOp op;
+        if (!ColumnMath::parseOp(data.operation, op))
+        {
+            data.errors++;
+            throw invalid_argument("Invalid operation.");
+        }
+        // Fisierul se citeste si coloana se calculeaza in lucrarea pasului; rezultatul apare la progres
+        data.columns = true;
+        data.executed = true;
+        io.out << "The result column is computed in the background." << endl;
+        io.ignore();
+    }
+
+    bool hasWork(const StepState &state) const override
+    {
+        return static_cast<const State &>(state).columns;
+    }
+
+    void work(StepState &state) const override
+    {
+        State &data = static_cast<State &>(state);
+        try
+        {
+            // Acelasi fisier si aceiasi operanzi: coloana calculata intr-o rulare anterioara
+            uint64_t content;
+            if (!Fingerprint::ofFile(string(data.fileName), content))
+                throw invalid_argument("Cannot open csv file " + string(data.fileName));
+            uint64_t key = Fingerprint().add("calculus").add(content).add(data.firstOperand).add(data.secondOperand).add(data.operation).get();
+            data.column = WorkCache::shared().find<Column>(key);
+            if (data.column == nullptr)
+            {
+                string error;
+                shared_ptr<const CsvTable> table = CsvTable::cached(string(data.fileName), error);
+                if (table == nullptr)
+                    throw invalid_argument(error);
+                CalcOp op = CalcOp::Add;
+                ColumnMath::parseOp(data.operation, op);
+                vector<double> left, right;
+                ColumnMath::Operand a = resolveOperand(*table, data.firstOperand, left);
+                ColumnMath::Operand b = resolveOperand(*table, data.secondOperand, right);
+                auto column = make_shared<Column>();
+                column->values.resize(a.broadcast && b.broadcast ? 1 : table->rows);
+                column->divisionsByZero = ColumnMath::apply(op, a, b, column->values.data(), column->values.size());
+                WorkCache::shared().store<Column>(key, column, column->values.size() * sizeof(double));
+                data.column = column;
+            }
+            data.rows = data.column->values.size();
+            data.divisionsByZero = data.column->divisionsByZero;
+        }
+        catch (const invalid_argument &e)
+        {
+            // problem e doar pentru afisare; graful trece eroarea in failure, ca pasii care asteapta sa o vada
+            data.problem = e.what();
+            data.rows = 0;
+            data.column.reset();
+            throw;
+        }
+    }
+
+    string extractInfo(const StepState &state) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.columns)
+        {
+            return "File = " + string(data.fileName) + ", Operand1 = " + string(data.firstOperand) + ", Operand2 = " + string(data.secondOperand) + ", Operation = " + string(data.operation) +
+                   ", Rows = " + to_string(data.rows) + ", Divisions by zero = " + to_string(data.divisionsByZero) + (data.problem.empty() ? "" : ", Problem = " + string(data.problem));
+        }
+        if (!data.expression.empty())
+        {
+            return "Expression = " + string(data.expression) + ", Result = " + to_string(data.result);
+        }
+        if (data.result == 0.0f)
+        {
+            return "Result is empty.";
+        }
+        return "Number1 = " + to_string(data.first.number) + ", Number2 = " + to_string(data.second.number) + ", Operation = " + string(data.operation) + ", Result = " + to_string(data.result);
+    }
+
+    // In fisierul de iesire coloana rezultat urmeaza rezumatului, cate o valoare pe linie
+    void streamInfo(const StepState &state, ChunkPipe &pipe) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        pipe.write(extractInfo(state));
+        char number[32];
+        if (data.column == nullptr)
+            return;
+        for (double value : data.column->values)
+        {
+            number[0] = '\n';
+            auto end = to_chars(number + 1, number + sizeof(number), value).ptr;
+            pipe.write(string_view(number, end - number));
+        }
+    }
+
+    void displayProgress(const StepState &state, FlowIO &io) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.result == 0.0f && !data.columns && data.expression.empty())
+        {
+            return;
+        }
+        time_t now = time(nullptr);
+        io.out << "Calculus Step is completed." << endl;
+        if (data.columns && !data.problem.empty())
+            io.out << "The result column could not be computed: " << data.problem << endl;
+        else if (data.columns)
+        {
+            io.out << "Result column: " << data.rows << " rows";
+            if (data.divisionsByZero != 0)
+                io.out << ", " << data.divisionsByZero << " divisions by zero (NaN)";
+            io.out << endl;
+            for (size_t i = 0; data.column != nullptr && i < data.column->values.size() && i < 5; i++)
+                io.out << "\t" << data.column->values[i] << endl;
+        }
+        io.out << "Number of error screens displayed: " << data.errors << endl;
+        io.out << "Completion time: " << timeText(now) << endl;
+    }
+};
+
+class TextFileInputStep : public FlowStep
+{
+public:
+    struct State : StepState
+    {
+        pmr::string fileDescription, fileName;
+
+        State(pmr::memory_resource *arena) : fileDescription(arena), fileName(arena) {}
+    };
+
+    TextFileInputStep(string name, string description) : FlowStep(name, description) {}
+
+    StepKind kind() const override { return StepKind::TextFile; }
+
+    StepState *createState(pmr::memory_resource &arena) const override { return allocate<State>(arena); }
+
+    void saveState(const StepState &state, SnapshotWriter &w) const override
+    {
+        FlowStep::saveState(state, w);
+        const State &data = static_cast<const State &>(state);
+        w.putString(data.fileDescription);
+        w.putString(data.fileName);
+    }
+    void loadState(StepState &state, SnapshotReader &r) const override
+    {
+        FlowStep::loadState(state, r);
+        State &data = static_cast<State &>(state);
+        data.fileDescription = r.getString();
+        data.fileName = r.getString();
+    }
+
+    // Un fisier .txt, un director (toate fisierele .txt din el) sau un tipar ca "date/2026-10-*.txt"
+    bool validateInput(string_view fName) const override
+    {
+        if (FileSet::isDirectory(string(fName)))
+            return true;
+        string_view plainName = InputFile::withoutCodec(fName); // "date.txt.gz" e citit decomprimat
+        if (plainName.substr(plainName.find_last_of(".") + 1) == "txt") // fileName.find_last_of(".") determină ultima poziție a caracterului .
+            return true;
+        return false;
+    }
+
+    Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        State &data = static_cast<State &>(state);
+        displayDetails(io);
+        if (co_await Skip(state, io))
+        {
+            co_return;
+        }
+        else
+        {
+            optional<invalid_argument> failure;
+            try
+            {
+                io.out << "\tEnter file description : " << endl;
+                co_await io.line(data.fileDescription);
+                if (ValidText<InputRules::fileDescription>::check(data.fileDescription) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid file description. Description cannot be empty.");
+                }
+                io.out << "\tEnter file name:  " << endl;
+                co_await io.line(data.fileName);
+                if (validateInput(data.fileName) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid file name. The file name must contain the .txt extension (optionally followed by .gz, .zst, .bz2 or .xz) or name a directory.");
+                }
+                data.executed = true;
+            }
+            catch (const invalid_argument &e)
+            {
+                data.fileName = "";
+                data.fileDescription = "";
+                failure = e;
+            }
+            if (failure)
+                co_await ifError(*failure, state, io, run);
+        }
+    }
+
+    string extractInfo(const StepState &state) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.fileName.empty() && data.fileDescription.empty())
+        {
+            return "File name and file description are empty.";
+        }
+        return "Description = " + string(data.fileDescription) + ", File Name = " + string(data.fileName);
+    }
+
+    void displayProgress(const StepState &state, FlowIO &io) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.fileName.empty() && data.fileDescription.empty())
+        {
+            return;
+        }
+        time_t now = time(nullptr);
+        io.out << "Text file input step completed." << endl;
+        io.out << "Number of error screens displayed: " << data.errors << endl;
+        io.out << "Completion time: " << timeText(now) << endl;
+    }
+};
+
+class CsvFileInputStep : public FlowStep
+{
+public:
+    struct State : StepState
+    {
+        pmr::string fileDescription, fileName;
+        shared_ptr<const CsvTable> table; // coloanele fisierului, daca exista; nu se salveaza in snapshot
+
+        State(pmr::memory_resource *arena) : fileDescription(arena), fileName(arena) {}
+    };
+
+    CsvFileInputStep(string name, string description) : FlowStep(name, description) {}
+
+    StepKind kind() const override { return StepKind::CsvFile; }
+
+    StepState *createState(pmr::memory_resource &arena) const override { return allocate<State>(arena); }
+
+    void saveState(const StepState &state, SnapshotWriter &w) const override
+    {
+        FlowStep::saveState(state, w);
+        const State &data = static_cast<const State &>(state);
+        w.putString(data.fileDescription);
+        w.putString(data.fileName);
+    }
+    void loadState(StepState &state, SnapshotReader &r) const override
+    {
+        FlowStep::loadState(state, r);
+        State &data = static_cast<State &>(state);
+        data.fileDescription = r.getString();
+        data.fileName = r.getString();
+    }
+
+    // Fisierul se incarca pe coloane in timp ce utilizatorul trece la pasii urmatori
+    bool hasWork(const StepState &state) const override
+    {
+        return state.executed;
+    }
+    void work(StepState &state) const override
+    {
+        State &data = static_cast<State &>(state);
+        string error;
+        data.table = CsvTable::cached(string(data.fileName), error);
+        if (data.table == nullptr)
+            throw runtime_error(error);
+    }
+
+    // Un fisier .csv, un director (toate fisierele .csv din el) sau un tipar ca "date/2026-10-*.csv"
+    bool validateInput(string_view fName) const override
+    {
+        if (FileSet::isDirectory(string(fName)))
+            return true;
+        string_view plainName = InputFile::withoutCodec(fName); // "date.csv.gz" e citit decomprimat
+        if (plainName.substr(plainName.find_last_of(".") + 1) == "csv") // fileName.find_last_of(".") determină ultima poziție a caracterului .
+            return true;
+        return false;
+    }
+
+    Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        State &data = static_cast<State &>(state);
+        displayDetails(io);
+        if (co_await Skip(state, io))
+        {
+            co_return;
+        }
+        else
+        {
+            optional<invalid_argument> failure;
+            try
+            {
+                io.out << "\tEnter file description : " << endl;
+                co_await io.line(data.fileDescription);
+                if (ValidText<InputRules::fileDescription>::check(data.fileDescription) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid file description. Description cannot be empty.");
+                }
+                io.out << "\tEnter file name:  " << endl;
+                co_await io.line(data.fileName);
+                if (validateInput(data.fileName) == false)
+                {
+                    data.errors++;
+                    throw invalid_argument("Invalid file name. The file name must contain the .csv extension (optionally followed by .gz, .zst, .bz2 or .xz) or name a directory.");
+                }
+                data.executed = true;
+            }
+            catch (const invalid_argument &e)
+            {
+                data.fileDescription = "";
+                data.fileName = "";
+                failure = e;
+            }
+            if (failure)
+                co_await ifError(*failure, state, io, run);
+        }
+    }
+
+    string extractInfo(const StepState &state) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.fileName.empty() && data.fileDescription.empty())
+        {
+            return "File name and file description are empty.";
+        }
+        return "Description = " + string(data.fileDescription) + ", File Name = " + string(data.fileName);
+    }
+
+    void displayProgress(const StepState &state, FlowIO &io) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.fileName.empty() && data.fileDescription.empty())
+        {
+            return;
+        }
+        time_t now = time(nullptr);
+        io.out << "Csv file input step completed." << endl;
+        io.out << "Number of error screens displayed: " << data.errors << endl;
+        io.out << "Completion time: " << timeText(now) << endl;
+    }
+};
+
+class DisplaySteps : public FlowStep
+{
+private:
+    const TextFileInputStep *textInputStep;
+    const CsvFileInputStep *csvInputStep;
+
+public:
+    struct State : StepState
+    {
+        int step = 0; // 6 = fisierul pasului text, 7 = fisierul pasului csv, 0 = niciun fisier ales
+        pmr::string fileName;
+        shared_ptr<const CsvTable> table;
+
+        State(pmr::memory_resource *arena) : fileName(arena) {}
+    };
+
+    DisplaySteps(string name, string description, const TextFileInputStep *TextInputStep, const CsvFileInputStep *CsvInputStep) : FlowStep(name, description), textInputStep(TextInputStep), csvInputStep(CsvInputStep) {}
+
+    StepKind kind() const override { return StepKind::Display; }
+
+    StepState *createState(pmr::memory_resource &arena) const override { return allocate<State>(arena); }
+
+    void saveState(const StepState &state, SnapshotWriter &w) const override
+    {
+        FlowStep::saveState(state, w);
+        const State &data = static_cast<const State &>(state);
+        w.putI32(data.step);
+        w.putString(data.fileName);
+    }
+    void loadState(StepState &state, SnapshotReader &r) const override
+    {
+        FlowStep::loadState(state, r);
+        State &data = static_cast<State &>(state);
+        data.step = r.getI32();
+        data.fileName = r.getString();
+    }
+
+    Task<> selectPreviousStep(State &data, FlowIO &io, const FlowRun &run) const
+    {
+        io.out << "Choose file type to read (txt/csv): ";
+        string file_type;
+        co_await io.token(file_type);
+
+        if (file_type == "txt")
+        {
+            const StepState *source = run.latest(textInputStep);
+            if (source != nullptr && source->skipped == false)
+            {
+                data.fileName = static_cast<const TextFileInputStep::State *>(source)->fileName;
+                data.step = 6;
+            }
+        }
+        else if (file_type == "csv")
+        {
+            const StepState *source = run.latest(csvInputStep);
+            if (source != nullptr && source->skipped == false)
+            {
+                if (!co_await run.ready(source, io))
+                    io.out << "The csv file could not be loaded: " << source->failure << endl;
+                data.fileName = static_cast<const CsvFileInputStep::State *>(source)->fileName;
+                data.table = static_cast<const CsvFileInputStep::State *>(source)->table;
+                data.step = 7;
+            }
+        }
+        else
+        {
+            io.out << "Invalid file type selected. Try again." << endl;
+            data.errors++;
+            co_await selectPreviousStep(data, io, run);
+        }
+    }
+
+    Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        State &data = static_cast<State &>(state);
+        displayDetails(io);
+        if (co_await Skip(state, io))
+        {
+            co_return;
+        }
+        else
+        {
+            co_await selectPreviousStep(data, io, run);
+
+            if (data.step != 0)
+            {
+                if (data.step == 6)
+                    readFromTextFile(string(data.fileName), data, io);
+                else
+                {
+                    readFromCsvFile(string(data.fileName), data, io);
+                    displayColumns(data, io);
+                }
+            }
+            else
+            {
+                io.out << "No previous step provided." << endl;
+            }
+        }
+    }
+
+    void readFromTextFile(string fileName, StepState &state, FlowIO &io) const
+    {
+        if (FileSet::isSet(fileName))
+        {
+            io.out << "Content of Text Files:" << endl;
+            Metrics::shared().addBytes(Metrics::TextRead, copySet(fileName, ".txt", false, state, io));
+            return;
+        }
+        InputFile file;
+        if (!file.open(fileName))
+        {
+            io.out << "Error opening the text file " << fileName << endl;
+            Log::warning("Cannot open " + fileName);
+            state.errors++;
+            return;
+        }
+        io.out << "Content of Text File:" << endl;
+        Metrics::shared().addBytes(Metrics::TextRead, copyContent(file, fileName, state, io));
+    }
+
+    void readFromCsvFile(string fileName, StepState &state, FlowIO &io) const
+    {
+        if (FileSet::isSet(fileName))
+        {
+            io.out << "Content of CSV Files:" << endl;
+            Metrics::shared().addBytes(Metrics::CsvRead, copySet(fileName, ".csv", true, state, io));
+            return;
+        }
+        InputFile file;
+        if (!file.open(fileName))
+        {
+            io.out << "Error opening the csv file " << fileName << endl;
+            Log::warning("Cannot open " + fileName);
+            state.errors++;
+            return;
+        }
+        io.out << "Content of CSV File:" << endl;
+        Metrics::shared().addBytes(Metrics::CsvRead, copyContent(file, fileName, state, io));
+    }
+
+    // Continutul fisierului (decomprimat, daca e cazul) trimis la iesire pe bucati; ultima linie se termina cu \n
+    static uint64_t copyContent(InputFile &file, const string &fileName, StepState &state, FlowIO &io)
+    {
+        vector<char> buffer(InputFile::ChunkSize);
+        uint64_t bytes = 0;
+        char last = '\n';
+        for (size_t length; (length = file.read(buffer.data(), buffer.size())) != 0;)
+        {
+            io.out.write(buffer.data(), static_cast<streamsize>(length));
+            bytes += length;
+            last = buffer[length - 1];
+        }
+        if (last != '\n')
+            io.out << '\n';
+        io.out.flush();
+        if (!file.close())
+        {
+            io.out << "Error decompressing " << fileName << endl;
+            Log::warning("Cannot decompress " + fileName);
+            state.errors++;
+        }
+        return bytes;
+    }
+
+    // Fisierele setului, unul dupa altul; un fisier care nu poate fi citit e raportat si sarit
+    static uint64_t copySet(const string &fileName, string_view extension, bool sharedHeader, StepState &state, FlowIO &io)
+    {
+        FileSet::Reader reader(FileSet::expand(fileName, extension), sharedHeader);
+        if (reader.size() == 0)
+        {
+            io.out << "No files match " << fileName << endl;
+            Log::warning("No files match " + fileName);
+            state.errors++;
+            return 0;
+        }
+        uint64_t bytes = 0;
+        FileSet::Chunk chunk;
+        while (reader.next(chunk))
+        {
+            if (!chunk.error.empty())
+            {
+                io.out << chunk.error << endl;
+                Log::warning(chunk.error);
+                state.errors++;
+                continue;
+            }
+            io.out.write(chunk.data().data(), static_cast<streamsize>(chunk.data().size()));
+            bytes += chunk.data().size();
+        }
+        io.out.flush();
+        return bytes;
+    }
+
+    void displayColumns(State &data, FlowIO &io) const
+    {
+        string error;
+        if (data.table == nullptr)
+            data.table = CsvTable::cached(string(data.fileName), error);
+        if (data.table == nullptr)
+            return;
+        io.out << "Columns (" << data.table->rows << " rows):" << endl;
+        for (auto &column : data.table->columns)
+            io.out << "\t" << column.name << " : " << column.typeName() << endl;
+        if (data.table->malformedRows != 0)
+            io.out << "Rows with a wrong number of fields: " << data.table->malformedRows << endl;
+    }
+
+    // Daca fisierul nu poate fi deschis se intoarce un text gol
+    string extractInfo(const StepState &state) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        string content, error;
+        if (data.step == 0 || !FileSet::readAll(string(data.fileName), data.step == 6 ? ".txt" : ".csv", data.step == 7, content, error))
+        {
+            return "";
+        }
+        return content;
+    }
+
+    void streamInfo(const StepState &state, ChunkPipe &pipe) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.step == 0)
+            return;
+        if (FileSet::isSet(string(data.fileName)))
+        {
+            FileSet::Reader reader(FileSet::expand(string(data.fileName), data.step == 6 ? ".txt" : ".csv"), data.step == 7);
+            uint64_t bytes = 0;
+            FileSet::Chunk chunk;
+            while (reader.next(chunk))
+            {
+                if (!chunk.error.empty())
+                {
+                    Log::warning(chunk.error);
+                    continue;
+                }
+                pipe.write(chunk.data());
+                bytes += chunk.data().size();
+            }
+            Metrics::shared().addBytes(data.step == 6 ? Metrics::TextRead : Metrics::CsvRead, bytes);
+            return;
+        }
+        InputFile file;
+        if (!file.open(string(data.fileName)))
+            return;
+        uint64_t bytes = 0;
+        for (size_t length; (length = file.read(pipe.acquire(), pipe.available())) != 0;)
+        {
+            pipe.commit(length);
+            bytes += length;
+        }
+        if (!file.close())
+            Log::warning("Cannot decompress " + string(data.fileName));
+        Metrics::shared().addBytes(data.step == 6 ? Metrics::TextRead : Metrics::CsvRead, bytes);
+    }
+
+    void displayProgress(const StepState &state, FlowIO &io) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.step != 0)
+        {
+            time_t now = time(nullptr);
+            io.out << "Display step completed." << endl;
+            io.out << "Number of error screens displayed: " << data.errors << endl;
+            io.out << "Completion time: " << timeText(now) << endl;
+        }
+    }
+};
+
+// Frecventa cuvintelor din fisierul pasului TEXT FILE; fisierul e numarat in lucrarea pasului, in paralel
+class WordCountStep : public FlowStep
+{
+private:
+    const TextFileInputStep *textInputStep;
+
+public:
+    struct State : StepState
+    {
+        pmr::string fileName;
+        int topWords = 10;
+        shared_ptr<const WordCounts> counts; // rezultatul lucrarii; nu se salveaza in snapshot
+
+        State(pmr::memory_resource *arena) : fileName(arena) {}
+    };
+
+    WordCountStep(string name, string description, const TextFileInputStep *TextInputStep) : FlowStep(name, description), textInputStep(TextInputStep) {}
+
+    StepKind kind() const override { return StepKind::WordCount; }
+
+    StepState *createState(pmr::memory_resource &arena) const override { return allocate<State>(arena); }
+
+    void saveState(const StepState &state, SnapshotWriter &w) const override
+    {
+        FlowStep::saveState(state, w);
+        const State &data = static_cast<const State &>(state);
+        w.putString(data.fileName);
+        w.putI32(data.topWords);
+    }
+    void loadState(StepState &state, SnapshotReader &r) const override
+    {
+        FlowStep::loadState(state, r);
+        State &data = static_cast<State &>(state);
+        data.fileName = r.getString();
+        data.topWords = r.getI32();
+    }
+
+    // La "Reload the Step" se cere din nou doar numarul de cuvinte
+    Task<> reload(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        co_await readTopWords(static_cast<State &>(state), io, run);
+    }
+
+    Task<> readTopWords(State &data, FlowIO &io, const FlowRun &run) const
+    {
+        optional<invalid_argument> failure;
+        try
+        {
+            io.out << "\tHow many of the most frequent words should be kept (1 - " << WordCounts::MaxTop << ")? " << endl;
+            co_await io.token(data.topWords);
+            if (data.topWords < 1 || static_cast<size_t>(data.topWords) > WordCounts::MaxTop)
+            {
+                data.errors++;
+                throw invalid_argument("Invalid number of words. Choose between 1 and " + to_string(WordCounts::MaxTop) + ".");
+            }
+            data.executed = true;
+        }
+        catch (const invalid_argument &e)
+        {
+            data.topWords = 10;
+            failure = e;
+        }
+        if (failure)
+            co_await ifError(*failure, data, io, run);
+    }
+
+    Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        State &data = static_cast<State &>(state);
+        displayDetails(io);
+        if (co_await Skip(state, io))
+        {
+            co_return;
+        }
+        const StepState *source = run.latest(textInputStep);
+        if (source == nullptr || source->skipped)
+        {
+            io.out << "No previous TEXT FILE step provided." << endl;
+            data.errors++;
+            data.skipped = true;
+            co_return;
+        }
+        data.fileName = static_cast<const TextFileInputStep::State *>(source)->fileName;
+        co_await readTopWords(data, io, run);
+    }
+
+    // Fisierul se numara in timp ce utilizatorul trece la pasii urmatori
+    bool hasWork(const StepState &state) const override
+    {
+        return state.executed && !state.skipped;
+    }
+    void work(StepState &state) const override
+    {
+        State &data = static_cast<State &>(state);
+        string error;
+        data.counts = WordCounts::cached(string(data.fileName), error);
+        if (data.counts == nullptr)
+            throw runtime_error(error);
+    }
+
+    string extractInfo(const StepState &state) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.counts == nullptr)
+            return "Word frequencies of " + string(data.fileName) + " are not available.";
+        const WordCounts &counts = *data.counts;
+        string info = "Word frequencies of " + string(data.fileName) + ": " + to_string(counts.bytes) + " bytes, " + to_string(counts.lines) + " lines, " +
+                      to_string(counts.words) + " words, " + to_string(counts.distinct) + " distinct";
+        size_t shown = min(counts.top.size(), static_cast<size_t>(max(data.topWords, 0)));
+        for (size_t i = 0; i < shown; i++)
+            info += "\n" + to_string(i + 1) + ". " + counts.top[i].first + " " + to_string(counts.top[i].second);
+        return info;
+    }
+
+    void displayProgress(const StepState &state, FlowIO &io) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        if (data.fileName.empty())
+        {
+            return;
+        }
+        time_t now = time(nullptr);
+        io.out << "Word count step completed." << endl;
+        io.out << extractInfo(state) << endl;
+        io.out << "Number of error screens displayed: " << data.errors << endl;
+        io.out << "Completion time: " << timeText(now) << endl;
+    }
+};
+
+class OutputStep : public FlowStep
+{
+public:
+    struct State : StepState
+    {
+        pmr::string nameOfFile;
+        pmr::string title;
+        pmr::string desc;
+        int step = 0;
+        pmr::vector<StepRun> selected; // pasii adaugati in fisier, in ordinea alegerii; scrisi de lucrarea pasului
+        bool writeFailed = false;
+
+        State(pmr::memory_resource *arena) : nameOfFile(arena), title(arena), desc(arena), selected(arena) {}
+    };
+
+    OutputStep(string name, string description) : FlowStep(name, description) {}
+
+    StepKind kind() const override { return StepKind::Output; }
+
+    StepState *createState(pmr::memory_resource &arena) const override { return allocate<State>(arena); }
+
+    void saveState(const StepState &state, SnapshotWriter &w) const override
+    {
+        FlowStep::saveState(state, w);
+        const State &data = static_cast<const State &>(state);
+        w.putString(data.nameOfFile);
+        w.putString(data.title);
+        w.putString(data.desc);
+        w.putI32(data.step);
+    }
+    void loadState(StepState &state, SnapshotReader &r) const override
+    {
+        FlowStep::loadState(state, r);
+        State &data = static_cast<State &>(state);
+        data.nameOfFile = r.getString();
+        data.title = r.getString();
+        data.desc = r.getString();
+        data.step = r.getI32();
+    }
+
+    bool validateInput(string_view input) const override
+    {
+        return ValidText<InputRules::outputName>::check(input);
+    }
+
+    // La "Reload the Step" se cer din nou doar datele fisierului
+    Task<> reload(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        co_await readFileDetails(static_cast<State &>(state), io, run);
+    }
+
+    Task<> readFileDetails(State &data, FlowIO &io, const FlowRun &run) const
+    {
+        optional<invalid_argument> failure;
+        try
+        {
+            io.out << "\tEnter the Name of the File : " << endl;
+            co_await io.line(data.nameOfFile);
+            if (validateInput(data.nameOfFile) == false)
+            {
+                data.errors++;
+                throw invalid_argument("Invalid name of file. Name cannot be empty.");
+            }
+            io.out << "\tEnter the Title of the File : " << endl;
+            co_await io.line(data.title);
+            if (ValidText<InputRules::outputTitle>::check(data.title) == false)
+            {
+                data.errors++;
+                throw invalid_argument("Invalid title. Title cannot be empty.");
+            }
+            io.out << "\tEnter the Description of the File : " << endl;
+            co_await io.line(data.desc);
+            if (ValidText<InputRules::outputDescription>::check(data.desc) == false)
+            {
+                data.errors++;
+                throw invalid_argument("Invalid description. Description cannot be empty.");
+            }
+        }
+        catch (const invalid_argument &e)
+        {
+            data.nameOfFile = "";
+            data.title = "";
+            data.desc = "";
+            failure = e;
+        }
+        if (failure)
+            co_await ifError(*failure, data, io, run);
+    }
+
+    // Pasii anteriori din aceeasi rulare pot fi adaugati in fisier
+    Task<> execute(StepState &state, FlowIO &io, const FlowRun &run) const override
+    {
+        State &data = static_cast<State &>(state);
+        displayDetails(io);
+        if (co_await Skip(state, io))
+        {
+            co_return;
+        }
+        else
+        {
+            co_await readFileDetails(data, io, run);
+            co_await selectPreviousStep(data, io, run);
+        }
+    }
+
+    Task<> selectPreviousStep(State &data, FlowIO &io, const FlowRun &run) const
+    {
+        string answer;
+        io.out << "Do you want to add information from the previous steps to the file? ";
+        io.out << "Choose yes / no ";
+        co_await io.token(answer);
+        if (answer == "no")
+            io.out << "The generated text file is: " << data.nameOfFile << " with title: " << data.title << " and description: " << description << endl;
+        else if (answer == "yes")
+        {
+            io.out << "Steps you can choose from: " << endl;
+            for (size_t i = 0; i < run.size(); i++)
+            {
+                io.out << i + 1 << ". " << run[i].step->getName() << endl;
+            }
+            io.out << "\n\t\t\t Please enter your choice : ";
+            co_await io.token(data.step);
+            io.out << endl;
+            if (data.step >= 1 && static_cast<size_t>(data.step) <= run.size())
+            {
+                data.selected.push_back(run[data.step - 1]);
+                co_await selectPreviousStep(data, io, run);
+            }
+            else
+            {
+                io.out << "Invalid choice. Please choose from the options above." << endl;
+                data.errors++;
+                co_await selectPreviousStep(data, io, run);
+            }
+        }
+        else
+        {
+            io.out << "Invalid answer. Try again." << endl;
+            data.errors++;
+            co_await selectPreviousStep(data, io, run);
+        }
+    }
+
+    // Fisierul se scrie dupa ce pasii alesi si-au terminat lucrarile (de ex. o coloana calculata)
+    bool hasWork(const StepState &state) const override
+    {
+        return !static_cast<const State &>(state).selected.empty();
+    }
+    void inputs(const StepState &state, vector<const StepState *> &after) const override
+    {
+        for (auto &previous : static_cast<const State &>(state).selected)
+            after.push_back(previous.state);
+    }
+    void work(StepState &state) const override
+    {
+        State &data = static_cast<State &>(state);
+        for (auto &previous : data.selected)
+            generateOutputFile(previous, data);
+    }
+
+    void generateOutputFile(const StepRun &previous, State &data) const
+    {
+        OutputWriter &outputFile = OutputWriter::forFile(string(data.nameOfFile) + ".txt");
+        if (outputFile.isOpen())
+        {
+            OutputWriter::Record record(outputFile);
+            ChunkPipe pipe([&record](string_view chunk)
+                           { return record.write(chunk); });
+            if (previous.state->failure.empty())
+                previous.step->streamInfo(*previous.state, pipe);
+            else
+                pipe.write(previous.step->getName() + " failed: " + previous.state->failure); // nu se scriu date lipsa ca rezultat
+            pipe.write("\n");
+            bool written = pipe.finish();
+            if (!record.finish() || !written)
+            {
+                data.errors++;
+                data.writeFailed = true;
+                Log::error("Writing " + string(data.nameOfFile) + ".txt failed");
+            }
+        }
+        else
+        {
+            data.errors++;
+            data.writeFailed = true;
+            Log::error("Cannot open " + string(data.nameOfFile) + ".txt");
+        }
+    }
+
+    void displayProgress(const StepState &state, FlowIO &io) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        time_t now = time(nullptr);
+        if (data.writeFailed)
+            io.out << "Error writing output file. " << endl;
+        io.out << "OutputStep completed. File generated." << endl;
+        io.out << "File Name: " << data.nameOfFile << endl;
+        io.out << "File Title: " << data.title << endl;
+        io.out << "File Description: " << data.desc << endl;
+        io.out << "Number of error screens displayed: " << data.errors << endl;
+        io.out << "Completion time: " << timeText(now) << endl;
+    }
+    string extractInfo(const StepState &state) const override
+    {
+        const State &data = static_cast<const State &>(state);
+        return "Description = " + string(data.desc) + ", File Name = " + string(data.nameOfFile) + ", Title = " + string(data.title);
+    }
+};
+
+class EndStep : public FlowStep
+{
+public:
+    EndStep(string name, string description) : FlowStep(name, description) {}
+
+    StepKind kind() const override { return StepKind::End; }
+
+    Task<> execute(StepState &, FlowIO &io, const FlowRun &) const override
+    {
+        io.out << "End of flow" << endl;
+        co_return;
+    }
+    void displayProgress(const StepState &, FlowIO &io) const override
+    {
+        time_t now = time(nullptr);
+        io.out << "EndStep completed." << endl;
+        io.out << "Completion time: " << timeText(now) << endl;
+    }
+};
+
+// Fisier de inregistrari adaugate la sfarsit: fiecare are u32 lungime, u32 control (amprenta continutului)
+// si continutul. O scriere intrerupta lasa un capat stricat, care se recunoaste la citire si se taie.
+struct RecordFile
+{
+    static int openAppend(const string &fileName)
+    {
+#ifdef _WIN32
+        return _open(fileName.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        return ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+    }
+
+    static void close(int &file)
+    {
+        if (file >= 0)
+        {
+#ifdef _WIN32
+            _close(file);
+#else
+            ::close(file);
+#endif
+        }
+        file = -1;
+    }
+
+    static bool writeAll(int file, string_view bytes)
+    {
+        while (!bytes.empty())
+        {
+#ifdef _WIN32
+            int written = _write(file, bytes.data(), static_cast<unsigned>(min<size_t>(bytes.size(), 1 << 30)));
+#else
+            ssize_t written = ::write(file, bytes.data(), bytes.size());
+            if (written < 0 && errno == EINTR)
+                continue;
+#endif
+            if (written <= 0)
+                return false;
+            bytes.remove_prefix(static_cast<size_t>(written));
+        }
+        return true;
+    }
+
+    static bool sync(int file)
+    {
+#ifdef _WIN32
+        return _commit(file) == 0;
+#elif defined(__APPLE__)
+        return fsync(file) == 0;
+#else
+        return fdatasync(file) == 0;
+#endif
+    }
+
+    static bool truncate(const string &fileName, size_t length)
+    {
+#ifdef _WIN32
+        int file = _open(fileName.c_str(), _O_WRONLY | _O_BINARY);
+        bool ok = file >= 0 && _chsize_s(file, static_cast<long long>(length)) == 0;
+        if (file >= 0)
+            _close(file);
+        return ok;
+#else
+        return ::truncate(fileName.c_str(), static_cast<off_t>(length)) == 0;
+#endif
+    }
+
+    static uint32_t check(string_view payload)
+    {
+        return static_cast<uint32_t>(Fingerprint().add(payload).get());
+    }
+
+    static void frame(string_view payload, string &out)
+    {
+        uint32_t length = static_cast<uint32_t>(payload.size()), control = check(payload);
+        out.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        out.append(reinterpret_cast<const char *>(&control), sizeof(control));
+        out += payload;
+    }
+
+    // Inregistrarile de dupa antet (primii start octeti); intoarce lungimea partii corecte a fisierului
+    static size_t forEach(string_view data, size_t start, const function<void(string_view)> &visit)
+    {
+        size_t pos = start;
+        while (data.size() - pos >= 8)
+        {
+            uint32_t length, control;
+            memcpy(&length, data.data() + pos, sizeof(length));
+            memcpy(&control, data.data() + pos + 4, sizeof(control));
+            if (length > data.size() - pos - 8)
+                break;
+            string_view payload = data.substr(pos + 8, length);
+            if (check(payload) != control)
+                break;
+            try
+            {
+                visit(payload);
+            }
+            catch (const runtime_error &)
+            {
+                break;
+            }
+            pos += 8 + length;
+        }
+        return pos;
+    }
+};
+
+// Istoricul rularilor: fiecare rulare terminata a unui flow, cu rezultatul fiecarui pas, este adaugata la
+// sfarsitul segmentului activ (<prefix>.<id>.seg). Un segment plin este inchis si rezumat in index
+// (<prefix>.index): pentru fiecare flow numarul de rulari, intervalul de timp, erorile, pasii sariti si
+// histograma duratelor. O interogare foloseste rezumatele segmentelor aflate complet in intervalul cerut
+// si citeste doar segmentele de la marginile lui. Cand se strang prea multe segmente mici ele sunt unite
+// (compactare), iar rularile mai vechi decat perioada de pastrare sunt lasate deoparte.
+//   segment: "FLOWHIST", u32 versiune, u32 rezervat, apoi inregistrari: u32 lungime, u32 control, rularea
+//   index:   "FLOWHIDX", u32 versiune, u64 id-ul segmentului activ, u64 urmatorul id, u32 numar de segmente
+//            si pentru fiecare segment inchis id, octeti, rulari si rezumatul fiecarui flow
+class RunHistory
+{
+public:
+    static constexpr size_t Kinds = static_cast<size_t>(StepKind::End) + 1;
+
+    struct StepOutcome
+    {
+        StepKind kind;
+        bool skipped = false;
+        uint32_t errors = 0;
+        uint64_t nanos = 0;
+    };
+
+    struct Run
+    {
+        string flow;
+        int64_t startMicros = 0; // system_clock, de la 1970
+        uint64_t nanos = 0;
+        bool completed = true;
+        vector<StepOutcome> steps;
+    };
+
+    // Rezumatul unor rulari ale aceluiasi flow, dintr-un segment sau dintr-o interogare
+    struct Summary
+    {
+        uint64_t runs = 0, completed = 0, errors = 0, nanos = 0;
+        int64_t first = numeric_limits<int64_t>::max(), last = numeric_limits<int64_t>::min();
+        uint64_t executed[Kinds] = {}, skipped[Kinds] = {};
+        map<uint16_t, uint64_t> durations; // compartimente LatencyHistogram -> numar de rulari
+
+        void add(const Run &run)
+        {
+            runs++;
+            completed += run.completed;
+            nanos += run.nanos;
+            first = min(first, run.startMicros);
+            last = max(last, run.startMicros);
+            durations[static_cast<uint16_t>(LatencyHistogram::bucketOf(run.nanos))]++;
+            for (auto &step : run.steps)
+            {
+                size_t kind = static_cast<size_t>(step.kind) < Kinds ? static_cast<size_t>(step.kind) : 0;
+                executed[kind]++;
+                skipped[kind] += step.skipped;
+                errors += step.errors;
+            }
+        }
+
+        void merge(const Summary &other)
+        {
+            runs += other.runs;
+            completed += other.completed;
+            errors += other.errors;
+            nanos += other.nanos;
+            first = min(first, other.first);
+            last = max(last, other.last);
+            for (size_t kind = 0; kind < Kinds; kind++)
+            {
+                executed[kind] += other.executed[kind];
+                skipped[kind] += other.skipped[kind];
+            }
+            for (auto [bucket, count] : other.durations)
+                durations[bucket] += count;
+        }
+
+        // Limita de sus a compartimentului in care cade procentul cerut (eroare de cel mult 12.5%)
+        uint64_t percentile(double fraction) const
+        {
+            uint64_t rank = static_cast<uint64_t>(ceil(fraction * runs)), seen = 0;
+            for (auto [bucket, count] : durations)
+            {
+                seen += count;
+                if (seen >= max<uint64_t>(rank, 1))
+                    return LatencyHistogram::upperBound(bucket);
+            }
+            return 0;
+        }
+
+        void save(SnapshotWriter &w) const
+        {
+            w.putU64(runs);
+            w.putU64(completed);
+            w.putU64(errors);
+            w.putU64(nanos);
+            w.putU64(static_cast<uint64_t>(first));
+            w.putU64(static_cast<uint64_t>(last));
+            for (size_t kind = 0; kind < Kinds; kind++)
+            {
+                w.putU64(executed[kind]);
+                w.putU64(skipped[kind]);
+            }
+            w.putU32(static_cast<uint32_t>(durations.size()));
+            for (auto [bucket, count] : durations)
+            {
+                w.putU32(bucket);
+                w.putU64(count);
+            }
+        }
+
+        static Summary load(SnapshotReader &r)
+        {
+            Summary summary;
+            summary.runs = r.getU64();
+            summary.completed = r.getU64();
+            summary.errors = r.getU64();
+            summary.nanos = r.getU64();
+            summary.first = static_cast<int64_t>(r.getU64());
+            summary.last = static_cast<int64_t>(r.getU64());
+            for (size_t kind = 0; kind < Kinds; kind++)
+            {
+                summary.executed[kind] = r.getU64();
+                summary.skipped[kind] = r.getU64();
+            }
+            for (uint32_t i = r.getU32(); i > 0; i--)
+            {
+                uint16_t bucket = static_cast<uint16_t>(r.getU32());
+                summary.durations[bucket] = r.getU64();
+            }
+            return summary;
+        }
+    };
+
+    struct Report
+    {
+        Summary total;
+        size_t fromIndex = 0; // segmente folosite doar prin rezumat
+        size_t scanned = 0;   // segmente citite rulare cu rulare
+    };
+
+private:
+    struct Segment
+    {
+        uint64_t id = 0;
+        uint64_t bytes = 0;
+        map<string, Summary, less<>> flows;
+
+        int64_t first() const
+        {
+            int64_t value = numeric_limits<int64_t>::max();
+            for (auto &[name, summary] : flows)
+                value = min(value, summary.first);
+            return value;
+        }
+    };
+
+    static constexpr char segmentMagic[8] = {'F', 'L', 'O', 'W', 'H', 'I', 'S', 'T'};
+    static constexpr char indexMagic[8] = {'F', 'L', 'O', 'W', 'H', 'I', 'D', 'X'};
+    static constexpr uint32_t version = 1;
+    static constexpr size_t headerSize = 16;
+    static constexpr size_t PendingLimit = 64 << 10;
+
+    mutex lock;
+    string prefix;
+    uint64_t segmentLimit = 4 << 20;
+    size_t compactAfter = 8; // atatea segmente mici inchise declanseaza compactarea
+    int64_t retentionMicros = 0; // 0 = se pastreaza tot
+    vector<Segment> sealed;      // in ordinea timpului
+    Segment active;
+    uint64_t nextId = 1;
+    int fd = -1;
+    string pending; // inregistrari adaugate, inca nescrise in segmentul activ
+
+    string segmentName(uint64_t id) const
+    {
+        char number[24];
+        snprintf(number, sizeof(number), ".%06llu.seg", static_cast<unsigned long long>(id));
+        return prefix + number;
+    }
+
+    static void encode(const Run &run, SnapshotWriter &w)
+    {
+        w.putString(run.flow);
+        w.putU64(static_cast<uint64_t>(run.startMicros));
+        w.putU64(run.nanos);
+        w.putBool(run.completed);
+        w.putU32(static_cast<uint32_t>(run.steps.size()));
+        for (auto &step : run.steps)
+        {
+            w.putU8(static_cast<uint8_t>(step.kind));
+            w.putBool(step.skipped);
+            w.putU32(step.errors);
+            w.putU64(step.nanos);
+        }
+    }
+
+    static Run decode(SnapshotReader &r)
+    {
+        Run run;
+        run.flow = r.getString();
+        run.startMicros = static_cast<int64_t>(r.getU64());
+        run.nanos = r.getU64();
+        run.completed = r.getBool();
+        run.steps.resize(r.getU32());
+        for (auto &step : run.steps)
+        {
+            step.kind = static_cast<StepKind>(r.getU8());
+            step.skipped = r.getBool();
+            step.errors = r.getU32();
+            step.nanos = r.getU64();
+        }
+        return run;
+    }
+
+    static void frame(const Run &run, string &out)
+    {
+        SnapshotWriter w;
+        encode(run, w);
+        RecordFile::frame(w.data(), out);
+    }
+
+    // Trece prin rularile unui segment; intoarce lungimea partii corecte (0 daca nu e un segment)
+    static size_t forEachRun(string_view data, const function<void(const Run &)> &visit)
+    {
+        if (data.size() < headerSize || memcmp(data.data(), segmentMagic, sizeof(segmentMagic)) != 0)
+            return 0;
+        return RecordFile::forEach(data, headerSize, [&](string_view payload)
+                                   {
+                                       SnapshotReader reader(payload);
+                                       visit(decode(reader)); });
+    }
+
+    static string header()
+    {
+        string text(segmentMagic, sizeof(segmentMagic));
+        uint32_t fields[2] = {version, 0};
+        text.append(reinterpret_cast<const char *>(fields), sizeof(fields));
+        return text;
+    }
+
+    bool writePending()
+    {
+        if (pending.empty())
+            return true;
+        bool ok = fd >= 0 && RecordFile::writeAll(fd, pending);
+        if (!ok)
+            Log::error("Cannot append to run history " + segmentName(active.id));
+        active.bytes += pending.size();
+        pending.clear();
+        return ok;
+    }
+
+    bool writeIndex()
+    {
+        SnapshotWriter w;
+        w.putBytes(string_view(indexMagic, sizeof(indexMagic)));
+        w.putU32(version);
+        w.putU64(active.id);
+        w.putU64(nextId);
+        w.putU32(static_cast<uint32_t>(sealed.size()));
+        for (auto &segment : sealed)
+        {
+            w.putU64(segment.id);
+            w.putU64(segment.bytes);
+            w.putU32(static_cast<uint32_t>(segment.flows.size()));
+            for (auto &[name, summary] : segment.flows)
+            {
+                w.putString(name);
+                summary.save(w);
+            }
+        }
+        string fileName = prefix + ".index", temporary = fileName + ".tmp";
+        {
+            ofstream file(temporary, ios::binary | ios::trunc);
+            file << w.data();
+            if (!file)
+                return false;
+        }
+#ifdef _WIN32
+        remove(fileName.c_str());
+#endif
+        return rename(temporary.c_str(), fileName.c_str()) == 0;
+    }
+
+    bool readIndex(string &error)
+    {
+        MappedFile file;
+        if (!file.open(prefix + ".index"))
+            return true; // istoric nou
+        string_view data = file.data();
+        try
+        {
+            SnapshotReader r(data);
+            if (data.size() < 8 || memcmp(data.data(), indexMagic, sizeof(indexMagic)) != 0)
+                throw runtime_error("not a run history index");
+            r.getU64();
+            if (r.getU32() != version)
+                throw runtime_error("unsupported version");
+            active.id = r.getU64();
+            nextId = r.getU64();
+            for (uint32_t i = r.getU32(); i > 0; i--)
+            {
+                Segment segment;
+                segment.id = r.getU64();
+                segment.bytes = r.getU64();
+                for (uint32_t flows = r.getU32(); flows > 0; flows--)
+                {
+                    string name = r.getString();
+                    segment.flows.emplace(move(name), Summary::load(r));
+                }
+                sealed.push_back(move(segment));
+            }
+        }
+        catch (const runtime_error &e)
+        {
+            error = "Cannot read run history index " + prefix + ".index: " + e.what();
+            return false;
+        }
+        return true;
+    }
+
+    // Segmentul activ e citit la deschidere; un capat scris pe jumatate este taiat
+    bool openActive(string &error)
+    {
+        string fileName = segmentName(active.id);
+        MappedFile file;
+        size_t valid = 0;
+        if (file.open(fileName))
+        {
+            valid = forEachRun(file.data(), [this](const Run &run)
+                               { active.flows[run.flow].add(run); });
+            size_t size = file.data().size();
+            file.close();
+            if (valid == 0 && size != 0)
+            {
+                error = fileName + " is not a run history segment";
+                return false;
+            }
+            if (valid != size && valid != 0)
+            {
+                Log::warning("Run history " + fileName + ": dropped " + to_string(size - valid) + " bytes of an interrupted write");
+                RecordFile::truncate(fileName, valid);
+            }
+        }
+        fd = RecordFile::openAppend(fileName);
+        if (fd < 0)
+        {
+            error = "Cannot open run history segment " + fileName;
+            return false;
+        }
+        if (valid == 0)
+        {
+            RecordFile::writeAll(fd, header());
+            valid = headerSize;
+        }
+        active.bytes = valid;
+        return true;
+    }
+
+    void seal()
+    {
+        writePending();
+        RecordFile::close(fd);
+        if (!active.flows.empty())
+            sealed.push_back(move(active));
+        else
+            remove(segmentName(active.id).c_str());
+        active = Segment();
+        active.id = nextId++;
+        remove(segmentName(active.id).c_str()); // ramas de la o inchidere intrerupta
+        fd = RecordFile::openAppend(segmentName(active.id));
+        RecordFile::writeAll(fd, header());
+        active.bytes = headerSize;
+        compact();
+        writeIndex();
+    }
+
+    // Uneste segmentele inchise mici, de la cel mai vechi, intr-unul singur; rularile prea vechi raman pe dinafara
+    void compact()
+    {
+        if (sealed.empty())
+            return;
+        int64_t oldest = numeric_limits<int64_t>::min();
+        if (retentionMicros > 0)
+            oldest = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count() - retentionMicros;
+        uint64_t large = compactAfter * segmentLimit;
+        size_t start = 0;
+        if (sealed.front().first() >= oldest)
+        {
+            while (start < sealed.size() && sealed[start].bytes >= large)
+                start++;
+        }
+        size_t end = start;
+        while (end < sealed.size() && end - start < compactAfter && sealed[end].bytes < large)
+            end++;
+        bool expired = start < sealed.size() && sealed[start].first() < oldest;
+        if (expired && end == start)
+            end = start + 1;
+        if (end - start < compactAfter && !expired)
+            return;
+
+        Segment merged;
+        merged.id = nextId++;
+        string fileName = segmentName(merged.id), temporary = fileName + ".tmp", out = header();
+        for (size_t i = start; i < end; i++)
+        {
+            MappedFile file;
+            if (!file.open(segmentName(sealed[i].id)))
+                continue;
+            forEachRun(file.data(), [&](const Run &run)
+                       {
+                           if (run.startMicros < oldest)
+                               return;
+                           frame(run, out);
+                           merged.flows[run.flow].add(run); });
+        }
+        merged.bytes = out.size();
+        int file = RecordFile::openAppend(temporary);
+        bool ok = file >= 0 && RecordFile::writeAll(file, out);
+        RecordFile::close(file);
+        if (!ok || rename(temporary.c_str(), fileName.c_str()) != 0)
+        {
+            Log::error("Run history compaction failed writing " + fileName);
+            remove(temporary.c_str());
+            return;
+        }
+        vector<uint64_t> removed;
+        for (size_t i = start; i < end; i++)
+            removed.push_back(sealed[i].id);
+        sealed.erase(sealed.begin() + start, sealed.begin() + end);
+        if (!merged.flows.empty())
+            sealed.insert(sealed.begin() + start, move(merged));
+        else
+            remove(fileName.c_str());
+        // indexul nou este scris inainte ca segmentele vechi sa dispara
+        if (writeIndex())
+        {
+            for (uint64_t id : removed)
+                remove(segmentName(id).c_str());
+        }
+        Log::info("Run history: compacted " + to_string(removed.size()) + " segments");
+    }
+
+    // Rezumatul unui segment pentru interogare: direct din index daca intervalul il cuprinde, altfel citit
+    void collect(const Segment &segment, string_view flow, int64_t from, int64_t to, Report &report)
+    {
+        bool inside = true, touches = false;
+        for (auto &[name, summary] : segment.flows)
+        {
+            if (!flow.empty() && name != flow)
+                continue;
+            if (summary.last < from || summary.first > to)
+                continue;
+            touches = true;
+            inside = inside && summary.first >= from && summary.last <= to;
+        }
+        if (!touches)
+            return;
+        if (inside)
+        {
+            report.fromIndex++;
+            for (auto &[name, summary] : segment.flows)
+            {
+                if ((flow.empty() || name == flow) && summary.last >= from && summary.first <= to)
+                    report.total.merge(summary);
+            }
+            return;
+        }
+        report.scanned++;
+        MappedFile file;
+        if (!file.open(segmentName(segment.id)))
+            return;
+        forEachRun(file.data(), [&](const Run &run)
+                   {
+                       if ((flow.empty() || run.flow == flow) && run.startMicros >= from && run.startMicros <= to)
+                           report.total.add(run); });
+    }
+
+public:
+    static RunHistory &shared()
+    {
+        static RunHistory history;
+        return history;
+    }
+
+    ~RunHistory()
+    {
+        close();
+    }
+
+    bool isOpen()
+    {
+        lock_guard<mutex> guard(lock);
+        return fd >= 0;
+    }
+
+    // retentionDays = 0 pastreaza toate rularile
+    bool open(const string &Prefix, string &error, int retentionDays = 0, uint64_t SegmentLimit = 4 << 20)
+    {
+        lock_guard<mutex> guard(lock);
+        prefix = Prefix;
+        segmentLimit = max<uint64_t>(SegmentLimit, 4096);
+        retentionMicros = static_cast<int64_t>(retentionDays) * 86400 * 1000000;
+        sealed.clear();
+        active = Segment();
+        if (!readIndex(error))
+            return false;
+        if (active.id == 0)
+            active.id = nextId++;
+        if (!openActive(error))
+            return false;
+        if (active.bytes >= segmentLimit)
+            seal();
+        if (!writeIndex())
+        {
+            error = "Cannot write run history index " + prefix + ".index";
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        lock_guard<mutex> guard(lock);
+        writePending();
+        RecordFile::close(fd);
+    }
+
+    void append(const Run &run)
+    {
+        lock_guard<mutex> guard(lock);
+        if (fd < 0)
+            return;
+        frame(run, pending);
+        active.flows[run.flow].add(run);
+        if (pending.size() >= PendingLimit)
+            writePending();
+        if (active.bytes + pending.size() >= segmentLimit)
+            seal();
+    }
+
+    // Rularile flow-ului (toate pentru un nume gol) pornite intre from si to, in microsecunde de la 1970
+    Report query(string_view flow, int64_t from, int64_t to)
+    {
+        lock_guard<mutex> guard(lock);
+        writePending();
+        Report report;
+        for (auto &segment : sealed)
+            collect(segment, flow, from, to, report);
+        collect(active, flow, from, to, report);
+        return report;
+    }
+
+    size_t segmentCount()
+    {
+        lock_guard<mutex> guard(lock);
+        return sealed.size() + 1;
+    }
+};
+
+// Pasii unui flow, construiti o singura data. Sunt doar cititi la rulare, deci toate flow-urile
+// si toate rularile lor pot folosi aceeasi definitie.
+class FlowDefinition
+{
+public:
+    vector<unique_ptr<FlowStep>> steps; // pasii rulati in ordine, fara OutputStep si EndStep
+    unique_ptr<OutputStep> outputStep;
+    unique_ptr<EndStep> endStep;
+
+    FlowDefinition()
+    {
+        steps.push_back(make_unique<TitleStep>("Title Step", "At this step you have to add a title and a subtitle."));
+        steps.push_back(make_unique<TextStep>("Text Step", "At this step you have to add a title and a copy (text)."));
+        steps.push_back(make_unique<TextInputStep>("Text Input Step", "At this step you must add a text entry and a description of the expected entry."));
+        steps.push_back(make_unique<NumberInputStep>("Number Input Step", "At this step you must add an entry number and a description of the expected entry."));
+        steps.push_back(make_unique<CalculusStep>("Calculus Step", "At this step you must add previous INPUT NUMBER steps and operation symbols, the operation will be performed and the result will be displayed."));
+        auto textFileStep = make_unique<TextFileInputStep>("Text File Input Step", "At this step you can add .txt files.");
+        auto csvFileStep = make_unique<CsvFileInputStep>("Csv File Input Step", "At this step you can add .csv files.");
+        auto displayStep = make_unique<DisplaySteps>("Display Step", "At this step you can provide as input a previous step that contains information: TEXT INPUT step or CSV INPUT step and you will be able to see the content of the file.", textFileStep.get(), csvFileStep.get());
+        auto wordCountStep = make_unique<WordCountStep>("Word Count Step", "At this step you can count the words of the file given at the TEXT FILE Input step and keep the most frequent ones.", textFileStep.get());
+        steps.push_back(move(textFileStep));
+        steps.push_back(move(csvFileStep));
+        steps.push_back(move(displayStep));
+        steps.push_back(move(wordCountStep));
+        outputStep = make_unique<OutputStep>("Output Step", "At this step you can generate a text file as a result, but you must provide a name, a title, a description for the file that will be generated and you can add information from the previous steps");
+        endStep = make_unique<EndStep>("End Step", "At this step you can signal the end of a flux.");
+    }
+
+    // Pozitia unui pas: steps, apoi OutputStep, apoi EndStep
+    uint32_t indexOf(const FlowStep *step) const
+    {
+        for (size_t i = 0; i < steps.size(); i++)
+        {
+            if (steps[i].get() == step)
+                return static_cast<uint32_t>(i);
+        }
+        return static_cast<uint32_t>(step == outputStep.get() ? steps.size() : steps.size() + 1);
+    }
+
+    const FlowStep *stepAt(uint32_t index) const
+    {
+        if (index < steps.size())
+            return steps[index].get();
+        if (index == steps.size())
+            return outputStep.get();
+        if (index == steps.size() + 1)
+            return endStep.get();
+        return nullptr;
+    }
+
+    static shared_ptr<const FlowDefinition> standard()
+    {
+        static shared_ptr<const FlowDefinition> definition = make_shared<const FlowDefinition>();
+        return definition;
+    }
+};
+
+// Punctul de reluare al unei rulari interactive, in <director>/<nume>.ckpt. Dupa fiecare executie a unui pas
+// se adauga doar starea ei, iar cand pasul e terminat (fara alte repetari) se adauga pozitia lui; fiecare
+// inregistrare e urmata de fsync. Fisierul e sters la sfarsitul flow-ului. Daca procesul se opreste inainte,
+// reluarea reface rularea din fisier si continua de la primul pas neterminat.
+//   antet: "FLOWCKPT", u32 versiune, u32 rezervat, apoi inregistrari RecordFile:
+//   Begin: nume, u64 pornire | Execution: u32 pas, u8 tip, starea, bool inclus | StepDone: u32 pas
+class FlowCheckpoint
+{
+public:
+    enum Record : uint8_t
+    {
+        Begin = 1,
+        Execution,
+        StepDone
+    };
+
+    struct Resume
+    {
+        int64_t startMicros = 0;
+        FlowRun run;
+        vector<size_t> included; // executiile care intra in rulare, in ordine
+        uint32_t nextStep = 0;    // primul pas neterminat
+    };
+
+private:
+    static constexpr char magic[8] = {'F', 'L', 'O', 'W', 'C', 'K', 'P', 'T'};
+    static constexpr uint32_t version = 2;
+    static constexpr size_t headerSize = 16;
+    static inline string directory; // gol = fara puncte de reluare
+
+    string fileName;
+    int fd = -1;
+    bool failed = false;
+
+    void put(const SnapshotWriter &w)
+    {
+        if (fd < 0)
+            return;
+        string record;
+        RecordFile::frame(w.data(), record);
+        if ((!RecordFile::writeAll(fd, record) || !RecordFile::sync(fd)) && !failed)
+        {
+            failed = true;
+            Log::error("Cannot write checkpoint " + fileName);
+        }
+    }
+
+public:
+    FlowCheckpoint() = default;
+    FlowCheckpoint(const FlowCheckpoint &) = delete;
+    FlowCheckpoint &operator=(const FlowCheckpoint &) = delete;
+    ~FlowCheckpoint()
+    {
+        RecordFile::close(fd);
+    }
+
+    static void setDirectory(const string &Directory)
+    {
+        directory = Directory;
+    }
+
+    static bool enabled()
+    {
+        return !directory.empty();
+    }
+
+    // Numele flow-ului poate contine orice; in numele fisierului raman literele si cifrele, plus amprenta lui
+    static string fileFor(string_view flow)
+    {
+        string safe;
+        for (char c : flow.substr(0, 64))
+            safe += isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' ? c : '_';
+        char hash[24];
+        snprintf(hash, sizeof(hash), "-%08x.ckpt", static_cast<unsigned>(Fingerprint().add(flow).get()));
+        return directory + "/" + safe + hash;
+    }
+
+    static bool exists(string_view flow)
+    {
+        struct stat info;
+        return enabled() && stat(fileFor(flow).c_str(), &info) == 0;
+    }
+
+    // Un fisier nou pentru o rulare care abia incepe (cel vechi, daca exista, se pierde)
+    bool start(const string &flow, int64_t startMicros)
+    {
+        if (!enabled())
+            return false;
+        fileName = fileFor(flow);
+        remove(fileName.c_str());
+        fd = RecordFile::openAppend(fileName);
+        if (fd < 0)
+        {
+            Log::error("Cannot create checkpoint " + fileName);
+            return false;
+        }
+        string header(magic, sizeof(magic));
+        uint32_t fields[2] = {version, 0};
+        header.append(reinterpret_cast<const char *>(fields), sizeof(fields));
+        RecordFile::writeAll(fd, header);
+        SnapshotWriter w;
+        w.putU8(Begin);
+        w.putString(flow);
+        w.putU64(static_cast<uint64_t>(startMicros));
+        put(w);
+        return true;
+    }
+
+    // Dupa load se continua in acelasi fisier
+    bool reopen(const string &flow)
+    {
+        fileName = fileFor(flow);
+        fd = RecordFile::openAppend(fileName);
+        return fd >= 0;
+    }
+
+    void execution(uint32_t stepIndex, const FlowStep &step, const StepState &state, bool included)
+    {
+        if (fd < 0)
+            return;
+        SnapshotWriter w;
+        w.putU8(Execution);
+        w.putU32(stepIndex);
+        w.putU8(static_cast<uint8_t>(step.kind()));
+        step.saveState(state, w);
+        w.putBool(included);
+        put(w);
+    }
+
+    void stepDone(uint32_t stepIndex)
+    {
+        if (fd < 0)
+            return;
+        SnapshotWriter w;
+        w.putU8(StepDone);
+        w.putU32(stepIndex);
+        put(w);
+    }
+
+    // Flow-ul s-a terminat; nu mai e nimic de reluat
+    void finish()
+    {
+        if (fd < 0)
+            return;
+        RecordFile::close(fd);
+        remove(fileName.c_str());
+    }
+
+    // Reface rularea din fisier; un capat scris pe jumatate este taiat
+    static bool load(const string &flow, const FlowDefinition &definition, Resume &resume, string &error)
+    {
+        string name = fileFor(flow);
+        MappedFile file;
+        if (!file.open(name))
+        {
+            error = "No checkpoint for flow '" + flow + "'.";
+            return false;
+        }
+        string_view data = file.data();
+        uint32_t fileVersion = 0;
+        if (data.size() >= headerSize)
+            memcpy(&fileVersion, data.data() + sizeof(magic), sizeof(fileVersion));
+        if (data.size() < headerSize || memcmp(data.data(), magic, sizeof(magic)) != 0 || fileVersion != version)
+        {
+            error = name + " is not a flow checkpoint.";
+            return false;
+        }
+        bool begun = false;
+        size_t valid = RecordFile::forEach(data, headerSize, [&](string_view payload)
+                                           {
+                                               SnapshotReader r(payload);
+                                               uint8_t type = r.getU8();
+                                               if (type == Begin)
+                                               {
+                                                   if (r.getString() != flow)
+                                                       throw runtime_error("Checkpoint of another flow.");
+                                                   resume.startMicros = static_cast<int64_t>(r.getU64());
+                                                   begun = true;
+                                               }
+                                               else if (type == Execution && begun)
+                                               {
+                                                   const FlowStep *step = definition.stepAt(r.getU32());
+                                                   if (step == nullptr || static_cast<uint8_t>(step->kind()) != r.getU8())
+                                                       throw runtime_error("Corrupt checkpoint.");
+                                                   size_t execution = resume.run.add(*step);
+                                                   step->loadState(resume.run.state(execution), r);
+                                                   if (r.getBool())
+                                                       resume.included.push_back(execution);
+                                               }
+                                               else if (type == StepDone && begun)
+                                                   resume.nextStep = r.getU32() + 1;
+                                               else
+                                                   throw runtime_error("Corrupt checkpoint."); });
+        if (!begun)
+        {
+            error = name + " does not belong to flow '" + flow + "'.";
+            return false;
+        }
+        if (valid != data.size())
+        {
+            Log::warning("Checkpoint " + name + ": dropped " + to_string(data.size() - valid) + " bytes of an interrupted write");
+            file.close();
+            RecordFile::truncate(name, valid);
+        }
+        return true;
+    }
+};
+
+class FlowBuilder
+{
+private:
+    string name;
+    shared_ptr<const FlowDefinition> definition = FlowDefinition::standard();
+    FlowRun lastRun; // pasii ultimei rulari, in ordine, si cu cei repetati
+    SharedCounter timesStarted;
+    SharedCounter timesCompleted;
+    SharedCounter NrScreenSkipped;
+    SharedCounter TotalErrors;
+    vector<pair<const StepState *, RunHistory::StepOutcome>> timings; // executiile rularii curente, pentru istoric
+
+    Task<> timedExecute(const FlowStep &step, StepState &state, FlowIO &io, const FlowRun &run)
+    {
+        auto start = chrono::steady_clock::now();
+        co_await step.execute(state, io, run);
+        chrono::nanoseconds duration = chrono::steady_clock::now() - start;
+        Metrics::shared().recordStep(step.kind(), Metrics::Execute, duration);
+        timings.push_back({&state, {step.kind(), false, 0, static_cast<uint64_t>(duration.count())}});
+    }
+
+    // Rularea terminata intra in istoric; starile dau pasii sariti si erorile
+    void recordHistory(int64_t startMicros, chrono::nanoseconds duration)
+    {
+        RunHistory::Run entry;
+        entry.flow = name;
+        entry.startMicros = startMicros;
+        entry.nanos = static_cast<uint64_t>(duration.count());
+        for (auto &[state, outcome] : timings)
+        {
+            outcome.skipped = state->skipped;
+            outcome.errors = static_cast<uint32_t>(max(state->errors, 0));
+            entry.steps.push_back(outcome);
+        }
+        timings.clear();
+        RunHistory::shared().append(entry);
+    }
+
+    // Dupa fiecare executie reusita utilizatorul poate repeta pasul; fiecare repetare are starea ei
+    // Fiecare executie terminata si apoi pasul intreg ajung in punctul de reluare.
+    // continuing: pasul a rulat deja inainte de reluare, deci se continua cu intrebarea de repetare.
+    Task<> executeRepeatable(const FlowStep &step, FlowRun &run, FlowIO &io, FlowCheckpoint &checkpoint, bool continuing = false)
+    {
+        int k = 1;
+        string answer;
+        uint32_t stepIndex = definition->indexOf(&step);
+        const StepState *earlier = continuing ? run.latest(&step) : nullptr;
+        bool skipped;
+        if (earlier != nullptr)
+            skipped = earlier->skipped;
+        else
+        {
+            size_t execution = run.add(step);
+            co_await timedExecute(step, run.state(execution), io, run);
+            skipped = run.state(execution).skipped;
+            checkpoint.execution(stepIndex, step, run.state(execution), !skipped);
+            if (!skipped)
+            {
+                run.include(execution);
+                run.schedule(execution);
+            }
+        }
+        if (skipped == false)
+        {
+            while (k == 1)
+            {
+                io.ignore();
+                io.out << "Do you want to add this step one more time? \n";
+                io.out << "Choose yes / no ";
+                co_await io.line(answer);
+                if (answer == "yes")
+                {
+                    size_t again = run.add(step);
+                    co_await timedExecute(step, run.state(again), io, run);
+                    checkpoint.execution(stepIndex, step, run.state(again), true);
+                    run.include(again);
+                    run.schedule(again);
+                }
+                else if (answer == "no")
+                {
+                    k = 0;
+                }
+                else
+                {
+                    io.out << "Invalid answer. Try again." << endl;
+                }
+            }
+        }
+        checkpoint.stepDone(stepIndex);
+    }
+
+    // Pasii de la firstStep incolo, apoi OutputStep si EndStep; run poate avea deja executii (reluare)
+    Task<const FlowRun *> executeFrom(FlowRun &run, uint32_t firstStep, int64_t startMicros, FlowCheckpoint &checkpoint, FlowIO &io)
+    {
+        timesStarted++;
+        timings.clear();
+        auto started = chrono::steady_clock::now();
+        Metrics::FlowCounters &counters = Metrics::shared().flow(name);
+        counters.started++;
+        for (size_t i = firstStep; i < definition->steps.size(); i++)
+        {
+            co_await executeRepeatable(*definition->steps[i], run, io, checkpoint, i == firstStep);
+        }
+        io.out << endl;
+        if (firstStep <= definition->steps.size())
+            co_await executeRepeatable(*definition->outputStep, run, io, checkpoint, firstStep == definition->steps.size());
+        co_await run.ready(nullptr, io);
+        run.finish();
+        StepState endState;
+        co_await definition->endStep->execute(endState, io, run);
+        definition->endStep->displayProgress(endState, io);
+        checkpoint.finish();
+        recordHistory(startMicros, chrono::steady_clock::now() - started);
+        counters.completed++;
+        counters.errors += run.totalErrors();
+        counters.skipped += run.skippedCount();
+        lastRun = move(run);
+        co_return &lastRun;
+    }
+
+public:
+    bool validateInput(string_view input)
+    {
+        return ValidText<InputRules::flowName>::check(input);
+    }
+    const string &getName() const
+    {
+        return name;
+    }
+    void setName(const string &Name)
+    {
+        name = Name;
+    }
+    const FlowRun &execute(FlowIO &io = FlowIO::console())
+    {
+        return *executeAsync(io).get();
+    }
+
+    // Rularea ca corutina: intr-o sesiune (io.loop) se suspenda cand asteapta un raspuns sau o lucrare
+    Task<const FlowRun *> executeAsync(FlowIO &io)
+    {
+        int correct = 0;
+        while (correct == 0)
+        {
+            io.ignore();
+            io.out << "\tEnter flow name:  " << endl;
+            co_await io.line(name);
+            if (!validateInput(name))
+            {
+                io.out << "Error: Invalid flow name. The name cannot be empty." << endl;
+            }
+            else
+                correct = 1;
+        }
+
+        io.out << "\t\t\t___________________________________________\n\n\n";
+        io.out << "\t\t\t_______________    STEPS    ___________________\n\n\n";
+        io.out << "\t| TITLE Step                  |" << endl;
+        io.out << "\t| TEXT Step                   |" << endl;
+        io.out << "\t| TEXT INPUT Step             |" << endl;
+        io.out << "\t| NUMBER INPUT Step           |" << endl;
+        io.out << "\t| CALCULUS Step               |" << endl;
+        io.out << "\t| TEXT FILE Input Step        |" << endl;
+        io.out << "\t| CSV FILE Input Step         |" << endl;
+        io.out << "\t| DISPLAY Steps               |" << endl;
+        io.out << "\t| WORD COUNT Step             |" << endl;
+        io.out << "\t| OUTPUT Step                 |" << endl;
+        io.out << "\t| END Step                    |" << endl;
+        io.out << "                                                     \n\n\n";
+        FlowRun run; // toti pasii si cu aia care se repeta
+        run.runStepsInBackground(io.interactive || io.loop != nullptr);
+        int64_t startMicros = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        FlowCheckpoint checkpoint;
+        if (io.interactive)
+            checkpoint.start(name, startMicros);
+        co_return co_await executeFrom(run, 0, startMicros, checkpoint, io);
+    }
+
+    // Continua rularea intrerupta a flow-ului flowName de la primul pas neterminat; nullptr daca nu se poate
+    const FlowRun *resume(const string &flowName, FlowIO &io = FlowIO::console())
+    {
+        FlowCheckpoint::Resume saved;
+        string error;
+        if (!FlowCheckpoint::load(flowName, *definition, saved, error))
+        {
+            io.out << error << endl;
+            return nullptr;
+        }
+        name = flowName;
+        FlowRun &run = saved.run;
+        run.runStepsInBackground(io.interactive);
+        for (size_t execution : saved.included)
+        {
+            run.include(execution);
+            run.schedule(execution);
+        }
+        const FlowStep *next = definition->stepAt(saved.nextStep);
+        io.out << "Resuming flow '" << name << "' at " << (next != nullptr ? next->getName() : string("the end")) << " ("
+               << saved.included.size() << " completed step executions restored)." << endl;
+        FlowCheckpoint checkpoint;
+        checkpoint.reopen(name);
+        return executeFrom(run, saved.nextStep, saved.startMicros, checkpoint, io).get();
+    }
+
+    const FlowRun &getLastRun() const
+    {
+        return lastRun;
+    }
+
+    int countErrors() const
+    {
+        return lastRun.totalErrors();
+    }
+
+    int countSkipped() const
+    {
+        return lastRun.skippedCount();
+    }
+
+    // Inregistrarea unui flow in snapshot: contoarele, apoi starea fiecarei executii din ultima rulare
+    void save(SnapshotWriter &w) const
+    {
+        w.putString(name);
+        w.putI32(timesStarted);
+        w.putI32(timesCompleted);
+        w.putI32(NrScreenSkipped);
+        w.putI32(TotalErrors);
+        lastRun.save(w, [this](const FlowStep *step)
+                     { return definition->indexOf(step); });
+    }
+
+    static FlowBuilder load(SnapshotReader &r)
+    {
+        FlowBuilder flow;
+        flow.name = r.getString();
+        flow.timesStarted = r.getI32();
+        flow.timesCompleted = r.getI32();
+        flow.NrScreenSkipped = r.getI32();
+        flow.TotalErrors = r.getI32();
+        const FlowDefinition *definition = flow.definition.get();
+        flow.lastRun = FlowRun::load(r, [definition](uint32_t index)
+                                     { return definition->stepAt(index); });
+        return flow;
+    }
+
+    // Rulare fara utilizator: raspunsurile vin din answers, nu se afiseaza nimic
+    const FlowRun &runHeadless(InputSource &answers)
+    {
+        HeadlessIO headless(answers);
+        return execute(headless);
+    }
+
+    void runflow(const FlowRun &allSteps, FlowIO &io = FlowIO::console())
+    {
+        timesStarted++;
+        io.out << "Flow '" << name << "' started." << endl;
+        int choose;
+        RunHistory::Run entry;
+        entry.flow = name;
+        entry.startMicros = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        auto started = chrono::steady_clock::now();
+        for (size_t i = 0; i < allSteps.size(); i++)
+        {
+            const StepRun &step = allSteps[i];
+            RunHistory::StepOutcome outcome{step.step->kind(), false, static_cast<uint32_t>(max(step.state->errors, 0)), 0};
+            auto stepStarted = chrono::steady_clock::now();
+            int obs = 1;
+            TotalErrors += step.state->errors;
+            io.out << "Step: " << step.step->getName() << endl;
+            io.out << "Choose: " << endl
+                   << "1. You complete the step action and select the next one " << endl
+                   << "2. Skip the step" << endl;
+            while (obs == 1)
+            {
+                io.getToken(choose);
+                if (choose == 1)
+                {
+                    step.step->displayProgress(*step.state, io);
+                    obs = 0;
+                }
+                else if (choose == 2)
+                {
+                    obs = 0;
+                    NrScreenSkipped++;
+                    outcome.skipped = true;
+                }
+                else
+                {
+                    io.out << "Invalid answer. Try again." << endl;
+                    obs = 1;
+                }
+            }
+            outcome.nanos = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - stepStarted).count());
+            entry.steps.push_back(outcome);
+        }
+        io.out << "Flow '" << name << "' completed." << endl;
+        timesCompleted++;
+        entry.nanos = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count());
+        RunHistory::shared().append(entry);
+
+        io.out << "Times Started: " << timesStarted << endl;
+        io.out << "Times Completed: " << timesCompleted << endl;
+        io.out << "Number of screens skipped: " << NrScreenSkipped << endl;
+        io.out << "Mean of errors: " << static_cast<double>(TotalErrors) / allSteps.size() << endl;
+    }
+};
+
+// Snapshot versionat al flow-urilor:
+//   antet: "FLOWSNAP", u32 versiune, u32 numar de flow-uri, u64 pozitia indexului
+//   inregistrarile flow-urilor (FlowBuilder::save), apoi indexul sortat dupa nume:
+//   pentru fiecare flow u64 pozitie, u64 lungime, u32 lungimea numelui, u32 rezervat
+// La deschidere se citeste doar antetul; un flow e decodat abia cand este cerut.
+class FlowSnapshot
+{
+private:
+    MappedFile file;
+    uint32_t count = 0;
+    uint64_t indexOffset = 0;
+
+    static constexpr char magic[8] = {'F', 'L', 'O', 'W', 'S', 'N', 'A', 'P'};
+    static constexpr size_t headerSize = 24;
+    static constexpr size_t entrySize = 24;
+
+    uint64_t entryField(uint32_t i, size_t field) const
+    {
+        uint64_t value;
+        memcpy(&value, file.data().data() + indexOffset + i * entrySize + field, sizeof(value));
+        return value;
+    }
+
+public:
+    static constexpr uint32_t version = 7;
+
+    struct Entry
+    {
+        string_view name;
+        string_view record;
+    };
+
+    bool open(const string &fileName, string &error)
+    {
+        count = 0;
+        if (!file.open(fileName))
+        {
+            error = "Cannot open snapshot " + fileName;
+            return false;
+        }
+        string_view data = file.data();
+        uint32_t fileVersion;
+        if (data.size() < headerSize || memcmp(data.data(), magic, sizeof(magic)) != 0)
+        {
+            error = fileName + " is not a flow snapshot";
+            file.close();
+            return false;
+        }
+        memcpy(&fileVersion, data.data() + 8, sizeof(fileVersion));
+        if (fileVersion != version)
+        {
+            error = "Unsupported snapshot version " + to_string(fileVersion);
+            file.close();
+            return false;
+        }
+        uint32_t flowCount;
+        memcpy(&flowCount, data.data() + 12, sizeof(flowCount));
+        memcpy(&indexOffset, data.data() + 16, sizeof(indexOffset));
+        if (indexOffset > data.size() || (data.size() - indexOffset) / entrySize < flowCount)
+        {
+            error = "Corrupt flow snapshot " + fileName;
+            file.close();
+            return false;
+        }
+        count = flowCount;
+        return true;
+    }
+
+    void close()
+    {
+        file.close();
+        count = 0;
+    }
+
+    uint32_t size() const
+    {
+        return count;
+    }
+
+    Entry entry(uint32_t i) const
+    {
+        string_view data = file.data();
+        uint64_t offset = entryField(i, 0);
+        uint64_t length = entryField(i, 8);
+        uint32_t nameLength;
+        memcpy(&nameLength, data.data() + indexOffset + i * entrySize + 16, sizeof(nameLength));
+        if (offset > data.size() || length > data.size() - offset || nameLength + 4 > length)
+            throw runtime_error("Corrupt flow snapshot.");
+        string_view record = data.substr(offset, length);
+        return {record.substr(4, nameLength), record};
+    }
+
+    // Primul flow cu numele dat (indexul e sortat), sau size() daca nu exista
+    uint32_t lowerBound(string_view name) const
+    {
+        uint32_t low = 0, high = count;
+        while (low < high)
+        {
+            uint32_t mid = low + (high - low) / 2;
+            if (entry(mid).name < name)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        return low;
+    }
+
+    static bool write(const string &fileName, vector<Entry> entries)
+    {
+        stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+                    { return a.name < b.name; });
+        SnapshotWriter w;
+        w.putBytes(string_view(magic, sizeof(magic)));
+        w.putU32(version);
+        w.putU32(static_cast<uint32_t>(entries.size()));
+        w.putU64(0);
+        vector<uint64_t> offsets;
+        for (auto &e : entries)
+        {
+            offsets.push_back(w.size());
+            w.putBytes(e.record);
+        }
+        w.patchU64(16, w.size());
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            w.putU64(offsets[i]);
+            w.putU64(entries[i].record.size());
+            w.putU32(static_cast<uint32_t>(entries[i].name.size()));
+            w.putU32(0);
+        }
+        // se scrie intr-un fisier temporar si apoi se inlocuieste, ca un snapshot vechi sa nu fie stricat la jumatate
+        string temporary = fileName + ".tmp";
+        ofstream out(temporary, ios::binary | ios::trunc);
+        if (!out.is_open())
+            return false;
+        out.write(w.data().data(), w.data().size());
+        out.close();
+        if (!out)
+            return false;
+#ifdef _WIN32
+        remove(fileName.c_str());
+#endif
+        return rename(temporary.c_str(), fileName.c_str()) == 0;
+    }
+};
+
+// Rezultatul unei rulari fara utilizator, impreuna cu flow-ul construit de ea
+struct RunResult
+{
+    string flowName;
+    bool completed = false; // false daca raspunsurile s-au terminat inainte de sfarsitul flow-ului
+    int stepsRun = 0;
+    int errors = 0;
+    int skipped = 0;
+    double seconds = 0;
+    size_t bytesInUse = 0; // memoria rularii (RunArena)
+    unique_ptr<FlowBuilder> flow;
+
+    static RunResult run(const vector<string> &answers)
+    {
+        RunResult result;
+        ScriptedInput input(&answers);
+        result.flow = make_unique<FlowBuilder>();
+        auto start = chrono::steady_clock::now();
+        try
+        {
+            result.stepsRun = static_cast<int>(result.flow->runHeadless(input).size());
+            result.completed = true;
+        }
+        catch (const InputExhausted &)
+        {
+            result.completed = false;
+        }
+        result.summarize(start);
+        return result;
+    }
+
+    // Restul rezultatului vine din flow, dupa ce rularea s-a oprit
+    void summarize(chrono::steady_clock::time_point start)
+    {
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        flowName = flow->getName();
+        errors = flow->countErrors();
+        skipped = flow->countSkipped();
+        bytesInUse = flow->getLastRun().bytesInUse();
+    }
+};
+
+// Multe rulari fara utilizator pe un singur fir: fiecare sesiune este o corutina care se suspenda cand
+// asteapta un raspuns, iar raspunsurile sosesc pe rand (deliver), ca de la utilizatori diferiti.
+// O sesiune suspendata tine doar cadrele corutinelor pasilor si raspunsurile primite inca necitite.
+class FlowSessions
+{
+private:
+    struct Session
+    {
+        SessionInput input;
+        HeadlessIO io{input};
+        unique_ptr<FlowBuilder> flow = make_unique<FlowBuilder>();
+        optional<Task<>> drive;
+    };
+
+    EventLoop loop;
+    unordered_map<size_t, unique_ptr<Session>> sessions; // doar pe firul buclei
+    vector<pair<size_t, RunResult>> results;
+    size_t active = 0;
+    bool closing = false;
+    size_t opened = 0;
+    thread runner;
+
+    Task<> drive(size_t id, Session &session)
+    {
+        RunResult result;
+        auto start = chrono::steady_clock::now();
+        try
+        {
+            result.stepsRun = static_cast<int>((co_await session.flow->executeAsync(session.io))->size());
+            result.completed = true;
+        }
+        catch (const InputExhausted &)
+        {
+            result.completed = false;
+        }
+        catch (const exception &e)
+        {
+            Log::error("Session " + to_string(id) + " stopped: " + e.what());
+        }
+        result.flow = move(session.flow);
+        result.summarize(start);
+        results.push_back({id, move(result)});
+        // sesiunea e stearsa dupa ce corutina ei s-a oprit de tot
+        loop.post([this, id]
+                  { sessions.erase(id); });
+        if (--active == 0 && closing)
+            loop.stop();
+    }
+
+public:
+    FlowSessions() : runner([this]
+                            { loop.run(); }) {}
+    FlowSessions(const FlowSessions &) = delete;
+    FlowSessions &operator=(const FlowSessions &) = delete;
+
+    ~FlowSessions()
+    {
+        finish();
+    }
+
+    // Porneste o sesiune noua; rularea ei merge pana la prima intrebare fara raspuns
+    size_t open()
+    {
+        size_t id = opened++;
+        loop.post([this, id]
+                  {
+                      Session &session = *sessions.emplace(id, make_unique<Session>()).first->second;
+                      session.io.loop = &loop;
+                      active++;
+                      session.drive.emplace(drive(id, session));
+                      session.drive->start(); });
+        return id;
+    }
+
+    void deliver(size_t id, string line)
+    {
+        loop.post([this, id, line = move(line)]() mutable
+                  {
+                      auto found = sessions.find(id);
+                      if (found != sessions.end())
+                          found->second->input.deliver(move(line)); });
+    }
+
+    // Nu mai vin raspunsuri: o sesiune care mai intreaba se opreste (rulare incompleta)
+    void close(size_t id)
+    {
+        loop.post([this, id]
+                  {
+                      auto found = sessions.find(id);
+                      if (found != sessions.end())
+                          found->second->input.close(); });
+    }
+
+    // Inchide toate sesiunile, asteapta sa se opreasca si da rezultatele in ordinea in care au fost deschise
+    vector<RunResult> finish()
+    {
+        vector<RunResult> done;
+        if (!runner.joinable())
+            return done;
+        loop.post([this]
+                  {
+                      closing = true;
+                      vector<Session *> running;
+                      for (auto &[id, session] : sessions)
+                          running.push_back(session.get());
+                      for (Session *session : running)
+                          session->input.close();
+                      if (active == 0)
+                          loop.stop(); });
+        runner.join();
+        sort(results.begin(), results.end(), [](const auto &a, const auto &b)
+             { return a.first < b.first; });
+        for (auto &[id, result] : results)
+            done.push_back(move(result));
+        results.clear();
+        return done;
+    }
+};
+
+// Totaluri pentru toate rularile trimise la WorkerPool
+struct RunTotals
+{
+    SharedCounter submitted;
+    SharedCounter completed;
+    SharedCounter failed;
+    SharedCounter errors;
+    SharedCounter skipped;
+};
+
+struct NameHash
+{
+    using is_transparent = void;
+    size_t operator()(string_view name) const { return hash<string_view>{}(name); }
+};
+
+// Flow-urile dupa nume: fiecare flow are adresa fixa (handle) cat timp nu e sters,
+// iar stergerea muta ultimul flow in locul celui sters, fara goluri in vector.
+// Parcurgerea cu index ramane valida cand se adauga flow-uri noi.
+class FlowRegistry
+{
+private:
+    vector<unique_ptr<FlowBuilder>> slots;
+    unordered_map<string, size_t, NameHash, equal_to<>> index;
+
+public:
+    FlowBuilder *find(string_view name) const
+    {
+        auto found = index.find(name);
+        return found == index.end() ? nullptr : slots[found->second].get();
+    }
+
+    // Un flow cu acelasi nume este inlocuit
+    FlowBuilder &insert(unique_ptr<FlowBuilder> flow)
+    {
+        auto [found, added] = index.try_emplace(flow->getName(), slots.size());
+        if (added)
+            slots.push_back(move(flow));
+        else
+            slots[found->second] = move(flow);
+        return *slots[found->second];
+    }
+
+    bool erase(string_view name)
+    {
+        auto found = index.find(name);
+        if (found == index.end())
+            return false;
+        size_t slot = found->second;
+        index.erase(found);
+        if (slot != slots.size() - 1)
+        {
+            slots[slot] = move(slots.back());
+            index.find(slots[slot]->getName())->second = slot;
+        }
+        slots.pop_back();
+        return true;
+    }
+
+    bool rename(string_view from, const string &to)
+    {
+        if (index.find(to) != index.end())
+            return false;
+        auto found = index.find(from);
+        if (found == index.end())
+            return false;
+        auto node = index.extract(found);
+        node.key() = to;
+        slots[node.mapped()]->setName(to);
+        index.insert(move(node));
+        return true;
+    }
+
+    size_t size() const
+    {
+        return slots.size();
+    }
+
+    FlowBuilder &operator[](size_t i) const
+    {
+        return *slots[i];
+    }
+};
+
+class FlowManager
+{
+private:
+    FlowRegistry flows;
+    FlowIO *io;
+    FlowSnapshot snapshot;
+    unordered_set<uint32_t> takenFromSnapshot; // decodate in flows, sterse sau inlocuite
+    unique_ptr<WorkerPool> pool;
+    RunTotals totals;
+
+    // Cauta un flow care nu a fost inca decodat din snapshot
+    long findInSnapshot(string_view flowName) const
+    {
+        for (uint32_t i = snapshot.lowerBound(flowName); i < snapshot.size() && snapshot.entry(i).name == flowName; i++)
+        {
+            if (takenFromSnapshot.count(i) == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    FlowBuilder *decodeFromSnapshot(uint32_t i)
+    {
+        SnapshotReader reader(snapshot.entry(i).record);
+        takenFromSnapshot.insert(i);
+        return &flows.insert(make_unique<FlowBuilder>(FlowBuilder::load(reader)));
+    }
+
+    // Flow-ul din memorie are prioritate fata de cel cu acelasi nume din snapshot
+    void shadowInSnapshot(string_view flowName)
+    {
+        long inSnapshot;
+        while ((inSnapshot = findInSnapshot(flowName)) >= 0)
+            takenFromSnapshot.insert(static_cast<uint32_t>(inSnapshot));
+    }
+
+public:
+    FlowManager(FlowIO &flowIO = FlowIO::console()) : io(&flowIO) {}
+
+    void setWorkers(size_t count)
+    {
+        pool = make_unique<WorkerPool>(count);
+    }
+
+    const RunTotals &getTotals() const
+    {
+        return totals;
+    }
+
+    // Ruleaza un set de raspunsuri pe un fir din pool; flow-ul rezultat nu e adaugat automat in registru
+    future<RunResult> submitRun(vector<string> answers)
+    {
+        if (!pool)
+            setWorkers(thread::hardware_concurrency());
+        totals.submitted++;
+        return pool->submit([this, answers = move(answers)]
+                            {
+                                RunResult result = RunResult::run(answers);
+                                if (result.completed)
+                                    totals.completed++;
+                                else
+                                    totals.failed++;
+                                totals.errors += result.errors;
+                                totals.skipped += result.skipped;
+                                return result; });
+    }
+
+    FlowBuilder *findFlow(string_view flowName)
+    {
+        FlowBuilder *flow = flows.find(flowName);
+        long inSnapshot;
+        if (flow == nullptr && (inSnapshot = findInSnapshot(flowName)) >= 0)
+            flow = decodeFromSnapshot(static_cast<uint32_t>(inSnapshot));
+        return flow;
+    }
+
+    FlowBuilder &addFlow(unique_ptr<FlowBuilder> flow)
+    {
+        shadowInSnapshot(flow->getName());
+        return flows.insert(move(flow));
+    }
+
+    void deleteFlow()
+    {
+        string flowName;
+        io->out << "Please enter the name of the flow you want to delete: " << endl;
+        io->out << "Name: " << endl;
+        io->getToken(flowName);
+
+        if (flows.erase(flowName) || findInSnapshot(flowName) >= 0)
+        {
+            shadowInSnapshot(flowName);
+            io->out << "Flow '" << flowName << "' deleted." << endl;
+        }
+        else
+        {
+            io->out << "Flow '" << flowName << "' not found." << endl;
+        }
+    }
+
+    void exportMetrics(const string &fileName)
+    {
+        if (Metrics::shared().writeFile(fileName))
+            io->out << "Metrics written to " << fileName << endl;
+        else
+            io->out << "Cannot write metrics to " << fileName << endl;
+    }
+
+    // Rularile din ultimele zile ale unui flow ("all" = toate flow-urile), din istoric
+    void historyReport(const string &flowName, int days)
+    {
+        if (!RunHistory::shared().isOpen())
+        {
+            io->out << "Run history is not enabled (start with --history <prefix>)." << endl;
+            return;
+        }
+        int64_t now = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        int64_t from = days > 0 ? now - static_cast<int64_t>(days) * 86400 * 1000000 : numeric_limits<int64_t>::min();
+        RunHistory::Report report = RunHistory::shared().query(flowName == "all" ? string_view() : string_view(flowName), from, now);
+        const RunHistory::Summary &total = report.total;
+        io->out << "Run history for " << (flowName == "all" ? "all flows" : "'" + flowName + "'");
+        if (days > 0)
+            io->out << " over the last " << days << " days";
+        io->out << ":" << endl;
+        if (total.runs == 0)
+        {
+            io->out << "No runs recorded." << endl;
+            return;
+        }
+        io->out << "Runs: " << total.runs << " (" << total.completed << " completed)" << endl;
+        io->out << "Duration p50 / p95 / p99: " << total.percentile(0.50) / 1e6 << " / " << total.percentile(0.95) / 1e6 << " / " << total.percentile(0.99) / 1e6 << " ms" << endl;
+        io->out << "Mean duration: " << total.nanos / total.runs / 1e6 << " ms" << endl;
+        io->out << "Errors: " << total.errors << " (" << static_cast<double>(total.errors) / total.runs << " per run)" << endl;
+        size_t mostSkipped = 0;
+        for (size_t kind = 1; kind < RunHistory::Kinds; kind++)
+        {
+            if (total.skipped[kind] > total.skipped[mostSkipped])
+                mostSkipped = kind;
+        }
+        if (total.skipped[mostSkipped] == 0)
+            io->out << "No skipped steps." << endl;
+        else
+            io->out << "Most skipped step: " << stepKindName(static_cast<StepKind>(mostSkipped)) << " (" << total.skipped[mostSkipped]
+                    << " of " << total.executed[mostSkipped] << " executions)" << endl;
+        io->out << "Segments summarized: " << report.fromIndex << ", scanned: " << report.scanned << endl;
+    }
+
+    void renameFlow()
+    {
+        string flowName, newName;
+        io->out << "Please enter the name of the flow you want to rename: " << endl;
+        io->out << "Name: " << endl;
+        io->getToken(flowName);
+        io->out << "New name: " << endl;
+        io->getToken(newName);
+
+        if (findFlow(flowName) == nullptr)
+        {
+            io->out << "Flow '" << flowName << "' not found." << endl;
+        }
+        else if (flowName == newName || findFlow(newName) != nullptr)
+        {
+            io->out << "Flow '" << newName << "' already exists." << endl;
+        }
+        else
+        {
+            flows.rename(flowName, newName);
+            io->out << "Flow '" << flowName << "' renamed to '" << newName << "'." << endl;
+        }
+    }
+
+    void runFlow()
+    {
+        string flowName;
+        io->out << "Please enter the name of the flow you want to run: " << endl;
+        io->out << "Name: " << endl;
+        io->getToken(flowName);
+        FlowBuilder *flow = findFlow(flowName);
+
+        if (flow != nullptr && flow->getLastRun().size() == 0)
+        {
+            io->out << "Flow '" << flowName << "' has no steps to run." << endl;
+        }
+        else if (flow != nullptr)
+        {
+            flow->runflow(flow->getLastRun(), *io);
+        }
+        else
+        {
+            io->out << "Flow '" << flowName << "' not found." << endl;
+        }
+    }
+
+    // Un flow intrerupt (procesul s-a oprit in timpul lui) continua de la primul pas neterminat
+    void resumeFlow(const string &flowName)
+    {
+        if (!FlowCheckpoint::enabled())
+        {
+            io->out << "Checkpoints are not enabled (start with --checkpoint <directory>)." << endl;
+            return;
+        }
+        auto flow = make_unique<FlowBuilder>();
+        if (flow->resume(flowName, *io) != nullptr)
+            addFlow(move(flow));
+    }
+
+    // Scrie toate flow-urile; cele inca nedecodate sunt copiate direct din snapshot-ul vechi
+    bool saveSnapshot(const string &fileName)
+    {
+        vector<SnapshotWriter> records(flows.size());
+        vector<FlowSnapshot::Entry> entries;
+        for (size_t i = 0; i < flows.size(); i++)
+        {
+            flows[i].save(records[i]);
+            string_view record = records[i].data();
+            entries.push_back({record.substr(4, flows[i].getName().size()), record});
+        }
+        string_view previous;
+        for (uint32_t i = 0; i < snapshot.size(); i++)
+        {
+            FlowSnapshot::Entry entry = snapshot.entry(i);
+            // snapshot-urile vechi pot avea mai multe flow-uri cu acelasi nume; se pastreaza primul
+            if (takenFromSnapshot.count(i) == 0 && !(i > 0 && entry.name == previous))
+                entries.push_back(entry);
+            previous = entry.name;
+        }
+        if (!FlowSnapshot::write(fileName, entries))
+        {
+            io->out << "Error writing snapshot " << fileName << endl;
+            return false;
+        }
+        io->out << "Saved " << entries.size() << " flows to " << fileName << endl;
+        return true;
+    }
+
+    bool loadSnapshot(const string &fileName)
+    {
+        // flow-urile ramase in snapshot-ul curent sunt decodate inainte ca fisierul sa fie inchis
+        for (uint32_t i = 0; i < snapshot.size(); i++)
+        {
+            if (takenFromSnapshot.count(i) == 0 && flows.find(snapshot.entry(i).name) == nullptr)
+                decodeFromSnapshot(i);
+        }
+        takenFromSnapshot.clear();
+        string error;
+        if (!snapshot.open(fileName, error))
+        {
+            io->out << error << endl;
+            return false;
+        }
+        for (size_t i = 0; i < flows.size(); i++)
+            shadowInSnapshot(flows[i].getName());
+        io->out << "Loaded snapshot with " << snapshot.size() << " flows from " << fileName << endl;
         return true;
     }
-    string getName() const
+
+    // Ruleaza fara utilizator toate seturile de raspunsuri din answersFile, de repeat ori
+    // Cu threads > 1 rularile merg in paralel, iar flow-urile sunt adaugate in ordinea din fisier
+    // Cu sessions > 1 rularile sunt sesiuni pe un singur fir (FlowSessions), deschise in grupuri de cate sessions;
+    // in grup primesc raspunsurile pe rand, cate unul fiecare, ca niste utilizatori care raspund in acelasi timp
+    void runBatch(const string &answersFile, int repeat = 1, int threads = 1, int sessions = 1)
+    {
+        vector<vector<string>> records = ScriptedInput::loadRecords(answersFile);
+        if (records.empty())
+        {
+            io->out << "No answers found in " << answersFile << endl;
+            return;
+        }
+        int completed = 0, failed = 0;
+        size_t runBytes = 0;
+        Log::info("Batch " + answersFile + ": " + to_string(records.size()) + " answer sets, repeated " + to_string(repeat) + " times on " + to_string(threads) + " threads");
+        auto collect = [&](RunResult &result)
+        {
+            runBytes += result.bytesInUse;
+            if (result.completed)
+            {
+                if (Log::enabled(LogLevel::Debug))
+                    Log::debug("Flow '" + result.flowName + "' completed in " + to_string(result.seconds * 1000) + " ms, errors: " + to_string(result.errors));
+                addFlow(move(result.flow));
+                completed++;
+            }
+            else
+            {
+                Log::warning("Flow '" + result.flowName + "' stopped: not enough answers");
+                failed++;
+            }
+        };
+        auto start = chrono::steady_clock::now();
+        if (sessions > 1)
+        {
+            FlowSessions group;
+            vector<const vector<string> *> all;
+            for (int r = 0; r < repeat; r++)
+            {
+                for (auto &record : records)
+                    all.push_back(&record);
+            }
+            for (size_t first = 0; first < all.size(); first += sessions)
+            {
+                size_t last = min(all.size(), first + sessions);
+                vector<size_t> ids;
+                size_t longest = 0;
+                for (size_t i = first; i < last; i++)
+                {
+                    ids.push_back(group.open());
+                    longest = max(longest, all[i]->size());
+                }
+                for (size_t turn = 0; turn < longest; turn++)
+                {
+                    for (size_t i = first; i < last; i++)
+                    {
+                        if (turn < all[i]->size())
+                            group.deliver(ids[i - first], (*all[i])[turn]);
+                    }
+                }
+                for (size_t id : ids)
+                    group.close(id);
+            }
+            for (auto &result : group.finish())
+                collect(result);
+        }
+        else if (threads > 1)
+        {
+            if (!pool || pool->size() != static_cast<size_t>(threads))
+                setWorkers(threads);
+            vector<future<RunResult>> pending;
+            for (int r = 0; r < repeat; r++)
+            {
+                for (auto &record : records)
+                    pending.push_back(submitRun(record));
+            }
+            for (auto &run : pending)
+            {
+                RunResult result = run.get();
+                collect(result);
+            }
+        }
+        else
+        {
+            for (int r = 0; r < repeat; r++)
+            {
+                for (auto &record : records)
+                {
+                    RunResult result = RunResult::run(record);
+                    collect(result);
+                }
+            }
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        Log::info("Batch " + answersFile + " finished in " + to_string(elapsed.count()) + " s");
+        io->out << "Batch finished: " << completed << " runs completed, " << failed << " runs without enough answers." << endl;
+        io->out << "Elapsed: " << elapsed.count() << " s";
+        if (elapsed.count() > 0)
+            io->out << ", runs per second: " << (completed + failed) / elapsed.count();
+        io->out << endl;
+        if (completed + failed != 0)
+            io->out << "Average run memory: " << runBytes / (completed + failed) << " bytes" << endl;
+        if (WorkCache::shared().hits() + WorkCache::shared().misses() != 0)
+            io->out << "Reused step results: " << WorkCache::shared().hits() << ", computed: " << WorkCache::shared().misses() << endl;
+    }
+
+    void interface()
+    {
+        int choice, k = 1;
+        string answer;
+
+        io->out << "\t\t\t\t______________________________________\n";
+        io->out << "\t\t\t\t                                      \n";
+        io->out << "\t\t\t\t              Welcome, user!          \n";
+        io->out << "\t\t\t\t                                      \n";
+        io->out << "\t\t\t\t______________________________________\n";
+        io->out << "\t\t\t\t                                      \n";
+        io->out << "\t\t\t\t|    1) Create flow       |\n";
+        io->out << "\t\t\t\t|                         |\n";
+        io->out << "\t\t\t\t|    2) Delete flow       |\n";
+        io->out << "\t\t\t\t|                         |\n";
+        io->out << "\t\t\t\t|    3) Run flow          |\n";
+        io->out << "\t\t\t\t|                         |\n";
+        io->out << "\t\t\t\t|    4) Save flows        |\n";
+        io->out << "\t\t\t\t|                         |\n";
+        io->out << "\t\t\t\t|    5) Load flows        |\n";
+        io->out << "\t\t\t\t|                         |\n";
+        io->out << "\t\t\t\t|    6) Rename flow       |\n";
+        io->out << "\t\t\t\t|                         |\n";
+        io->out << "\t\t\t\t|    7) Export metrics    |\n";
+        io->out << "\t\t\t\t|                         |\n";
+        io->out << "\t\t\t\t|    8) Run history       |\n";
+        io->out << "\t\t\t\t|                         |\n";
+        io->out << "\t\t\t\t|    9) Resume flow       |\n";
+        io->out << "\t\t\t\t|                         |\n";
+
+        while (k == 1)
+        {
+            io->ignore();
+            io->out << "Do you want to run, create or delete flows? \n";
+            io->out << "Choose yes / no ";
+            io->getLine(answer);
+            if (answer == "yes")
+            {
+                io->out << "\n\t\t\t Please select ";
+                io->getToken(choice);
+                switch (choice)
+                {
+                case 1:
+                {
+                    io->ignore();
+                    auto flow = make_unique<FlowBuilder>();
+                    flow->execute(*io);
+
+                    addFlow(move(flow));
+                    break;
+                }
+                case 2:
+                    io->ignore();
+                    deleteFlow();
+                    break;
+                case 3:
+                    io->ignore();
+                    runFlow();
+                    break;
+                case 4:
+                case 5:
+                {
+                    string fileName;
+                    io->ignore();
+                    io->out << "Snapshot file: " << endl;
+                    io->getLine(fileName);
+                    if (choice == 4)
+                        saveSnapshot(fileName);
+                    else
+                        loadSnapshot(fileName);
+                    break;
+                }
+                case 6:
+                    io->ignore();
+                    renameFlow();
+                    break;
+                case 7:
+                {
+                    string fileName;
+                    io->ignore();
+                    io->out << "Metrics file: " << endl;
+                    io->getLine(fileName);
+                    exportMetrics(fileName);
+                    break;
+                }
+                case 8:
+                {
+                    string flowName;
+                    int days;
+                    io->ignore();
+                    io->out << "Flow name (or all): " << endl;
+                    io->getLine(flowName);
+                    io->out << "Number of days (0 for all): " << endl;
+                    io->getToken(days);
+                    historyReport(flowName, days);
+                    break;
+                }
+                case 9:
+                {
+                    string flowName;
+                    io->ignore();
+                    io->out << "Name of the interrupted flow: " << endl;
+                    io->getLine(flowName);
+                    resumeFlow(flowName);
+                    break;
+                }
+                default:
+                    io->out << "\t\t\t Please select from the options given above \n"
+                            << endl;
+                }
+            }
+            else if (answer == "no")
+            {
+                k = 0;
+            }
+
+            else
+            {
+                io->out << "Invalid answer. Try again." << endl;
+            }
+        }
+    }
+};
+
+// Benchmark-uri pentru motorul de flow-uri: executia fiecarui tip de pas, cautarea unui flow dupa nume,
+// citirea fisierelor, scrierea in fisierul de iesire si o rulare completa fara utilizator.
+// Fisierele de intrare sunt generate la pornire (mereu acelasi continut) si sterse la sfarsit.
+// Rezultatele se scriu in JSON; fata de un JSON de referinta sunt semnalate cazurile mai lente decat pragul.
+class BenchmarkSuite
+{
+public:
+    struct Options
+    {
+        string resultsFile;
+        string baselineFile;
+        string filter;         // se ruleaza doar cazurile al caror nume contine acest text
+        double threshold = 10; // procente peste referinta considerate regresie
+        double seconds = 0.1;  // durata minima a unei masuratori
+        int scale = 1;         // inmulteste dimensiunea datelor generate si numarul de flow-uri
+    };
+
+    struct Result
+    {
+        string name;
+        uint64_t iterations = 0;
+        double nsPerOp = 0;
+        double bytesPerOp = 0; // 0 pentru cazurile care nu proceseaza date
+    };
+
+private:
+    static constexpr int Samples = 5;
+
+    Options options;
+    vector<Result> results;
+    const string textFile = "flow_bench_large.txt";
+    const string smallTextFile = "flow_bench_small.txt";
+    const string csvFile = "flow_bench_table.csv";
+    const string outputName = "flow_bench_output";
+
+    static uint64_t nextRandom(uint64_t &seed)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    }
+
+    static const char *word(uint64_t &seed)
     {
-        return name;
+        static const char *words[] = {"flow", "step", "title", "input", "number", "display", "output", "value", "column", "result", "text", "file"};
+        return words[nextRandom(seed) % size(words)];
     }
-    vector<FlowStep *> execute()
+
+    // Linii de 4-13 cuvinte, pana la bytes octeti
+    static bool generateText(const string &fileName, size_t bytes)
     {
-        int correct = 0;
-        while (correct == 0)
+        uint64_t seed = 0x9E3779B97F4A7C15ull;
+        string content;
+        content.reserve(bytes + 128);
+        while (content.size() < bytes)
         {
-            cin.ignore();
-            cout << "\tEnter flow name:  " << endl;
-            getline(cin, name);
-            if (!validateInput(name))
+            size_t words = 4 + nextRandom(seed) % 10;
+            for (size_t i = 0; i < words; i++)
             {
-                cout << "Error: Invalid flow name. The name cannot be empty." << endl;
+                if (i != 0)
+                    content += ' ';
+                content += word(seed);
             }
-            else
-                correct = 1;
+            content += '\n';
         }
+        ofstream file(fileName, ios::binary | ios::trunc);
+        file << content;
+        return static_cast<bool>(file);
+    }
 
-        cout << "\t\t\t___________________________________________\n\n\n";
-        cout << "\t\t\t_______________    STEPS    ___________________\n\n\n";
-        cout << "\t| TITLE Step                  |" << endl;
-        cout << "\t| TEXT Step                   |" << endl;
-        cout << "\t| TEXT INPUT Step             |" << endl;
-        cout << "\t| NUMBER INPUT Step           |" << endl;
-        cout << "\t| CALCULUS Step               |" << endl;
-        cout << "\t| TEXT FILE Input Step        |" << endl;
-        cout << "\t| CSV FILE Input Step         |" << endl;
-        cout << "\t| DISPLAY Steps               |" << endl;
-        cout << "\t| OUTPUT Step                 |" << endl;
-        cout << "\t| END Step                    |" << endl;
-        cout << "                                                     \n\n\n";
-        TitleStep *titleStep = new TitleStep("Title Step", "At this step you have to add a title and a subtitle.");
-        steps.push_back(titleStep);
-        TextStep *textStep = new TextStep("Text Step", "At this step you have to add a title and a copy (text).");
-        steps.push_back(textStep);
-        TextInputStep *textInputStep = new TextInputStep("Text Input Step", "At this step you must add a text entry and a description of the expected entry.");
-        steps.push_back(textInputStep);
-        NumberInputStep *numberInputStep = new NumberInputStep("Number Input Step", "At this step you must add an entry number and a description of the expected entry.");
-        steps.push_back(numberInputStep);
-        CalculusStep *calculusStep = new CalculusStep("Calculus Step", "At this step you must add previous INPUT NUMBER steps and operation symbols, the operation will be performed and the result will be displayed.");
-        steps.push_back(calculusStep);
-        TextFileInputStep *textFileStep = new TextFileInputStep("Text File Input Step", "At this step you can add .txt files.");
-        steps.push_back(textFileStep);
-        CsvFileInputStep *csvFileStep = new CsvFileInputStep("Csv File Input Step", "At this step you can add .csv files.");
-        steps.push_back(csvFileStep);
-        DisplaySteps *displayStep = new DisplaySteps("Display Step", "At this step you can provide as input a previous step that contains information: TEXT INPUT step or CSV INPUT step and you will be able to see the content of the file.", textFileStep, csvFileStep);
-        steps.push_back(displayStep);
-        OutputStep *outputStep = new OutputStep("Output Step", "At this step you can generate a text file as a result, but you must provide a name, a title, a description for the file that will be generated and you can add information from the previous steps");
-        EndStep *endStep = new EndStep("End Step", "At this step you can signal the end of a flux.");
-        int k = 1;
-        vector<FlowStep *> Allsteps; // toti pasii si cu aia care se repeta
-        timesStarted++;
-        string answer;
-        for (auto &step : steps)
+    // Coloane: id (intreg), name (text), quantity (intreg), price (numar cu zecimale)
+    static bool generateCsv(const string &fileName, size_t rows)
+    {
+        uint64_t seed = 0xD1B54A32D192ED03ull;
+        string content = "id,name,quantity,price\n";
+        content.reserve(rows * 32);
+        char number[32];
+        for (size_t row = 0; row < rows; row++)
         {
-            // int nrErrors = 0;
-            step->execute();
-            if (step->getSkipped() == false)
-            {
-                Allsteps.push_back(step);
-                while (k == 1)
-                {
-                    cin.ignore();
-                    cout << "Do you want to add this step one more time? \n";
-                    cout << "Choose yes / no ";
-                    getline(cin, answer);
-                    if (answer == "yes")
-                    {
-                        step->execute();
-                        Allsteps.push_back(step);
-                    }
-                    else if (answer == "no")
-                    {
-                        k = 0;
-                    }
-                    else
-                    {
-                        cout << "Invalid answer. Try again." << endl;
-                    }
-                }
-                k = 1;
-            }
+            content += to_string(row);
+            content += ',';
+            content += word(seed);
+            content += ',';
+            content += to_string(nextRandom(seed) % 1000);
+            content += ',';
+            auto end = to_chars(number, number + sizeof(number), static_cast<double>(nextRandom(seed) % 100000) / 100).ptr;
+            content.append(number, end);
+            content += '\n';
+        }
+        ofstream file(fileName, ios::binary | ios::trunc);
+        file << content;
+        return static_cast<bool>(file);
+    }
+
+    static uint64_t fileSize(const string &fileName)
+    {
+        ifstream file(fileName, ios::binary | ios::ate);
+        return file.is_open() ? static_cast<uint64_t>(file.tellg()) : 0;
+    }
+
+    // batch(n) face operatia de n ori. n este ales astfel incat o masuratoare sa dureze cel putin
+    // options.seconds; se pastreaza cea mai buna din Samples masuratori (cele mai putin deranjate de alte procese).
+    void measure(const string &name, double bytesPerOp, const function<void(uint64_t)> &batch)
+    {
+        if (name.find(options.filter) == string::npos)
+            return;
+        auto timed = [&batch](uint64_t n)
+        {
+            auto start = chrono::steady_clock::now();
+            batch(n);
+            return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        };
+        uint64_t n = 1;
+        double elapsed = timed(n);
+        while (elapsed < options.seconds / 10)
+        {
+            n *= 2;
+            elapsed = timed(n);
         }
+        n = max<uint64_t>(1, static_cast<uint64_t>(n * options.seconds / elapsed));
+        double samples[Samples];
+        for (double &sample : samples)
+            sample = timed(n) * 1e9 / n;
+        sort(begin(samples), end(samples));
+
+        Result result{name, n, samples[0], bytesPerOp};
+        cout << name << ": " << result.nsPerOp << " ns/op";
+        if (bytesPerOp != 0)
+            cout << ", " << megabytesPerSecond(result) << " MB/s";
         cout << endl;
-        outputStep->executeStep(Allsteps);
-        if (outputStep->getSkipped() == false)
+        results.push_back(result);
+    }
+
+    static double megabytesPerSecond(const Result &result)
+    {
+        return result.bytesPerOp / result.nsPerOp * 1e3;
+    }
+
+    // Raspunsurile cu care se executa o data fiecare tip de pas, fara erori
+    vector<string> script(StepKind kind) const
+    {
+        switch (kind)
         {
-            Allsteps.push_back(outputStep);
-            k = 1;
-            while (k == 1)
-            {
-                cin.ignore();
-                cout << "Do you want to add this step one more time? \n";
-                cout << "Choose yes / no ";
-                getline(cin, answer);
-                if (answer == "yes")
-                {
-                    outputStep->executeStep(Allsteps);
-                    Allsteps.push_back(outputStep);
-                }
-                else if (answer == "no")
+        case StepKind::Title:
+            return {"no", "Benchmark title", "Benchmark subtitle"};
+        case StepKind::Text:
+            return {"no", "Benchmark title", "A short text for the benchmark"};
+        case StepKind::TextInput:
+            return {"no", "some input", "What the input is"};
+        case StepKind::NumberInput:
+            return {"no", "12.5", "first number"};
+        case StepKind::Calculus:
+            return {"no", "numbers", "no", "12", "first", "no", "3", "second", "+"};
+        case StepKind::TextFile:
+            return {"no", "Benchmark text file", smallTextFile};
+        case StepKind::CsvFile:
+            return {"no", "Benchmark csv file", csvFile};
+        case StepKind::Display:
+            return {"no", "txt"};
+        case StepKind::WordCount:
+            return {"no", "10"};
+        case StepKind::Output:
+            return {"no", outputName, "Benchmark output", "Benchmark description", "no"};
+        case StepKind::End:
+            break;
+        }
+        return {};
+    }
+
+    // O rulare completa: titlu, un numar, fisierele text si csv, afisarea fisierului text, cuvintele lui
+    // si un fisier de iesire cu titlul, afisarea si cuvintele
+    vector<string> flowScript() const
+    {
+        return {"benchmark", "no", "Benchmark title", "Benchmark subtitle", "no", "yes", "yes",
+                "no", "12.5", "first number", "no", "yes",
+                "no", "Benchmark text file", smallTextFile, "no",
+                "no", "Benchmark csv file", csvFile, "no",
+                "no", "txt", "no",
+                "no", "10", "no",
+                "no", outputName, "Benchmark output", "Benchmark description", "yes", "1", "yes", "5", "yes", "6", "no", "no"};
+    }
+
+    void measureSteps(const FlowDefinition &definition)
+    {
+        vector<const FlowStep *> steps;
+        for (auto &step : definition.steps)
+            steps.push_back(step.get());
+        steps.push_back(definition.outputStep.get());
+        steps.push_back(definition.endStep.get());
+
+        // Pasul de afisare are nevoie de un fisier text ales mai devreme in rulare
+        FlowRun run;
+        for (const FlowStep *step : steps)
+        {
+            if (step->kind() != StepKind::TextFile)
+                continue;
+            vector<string> answers = script(StepKind::TextFile);
+            ScriptedInput input(&answers);
+            HeadlessIO io(input);
+            size_t execution = run.add(*step);
+            step->execute(run.state(execution), io, run).get();
+            run.include(execution);
+        }
+
+        for (const FlowStep *step : steps)
+        {
+            vector<string> answers = script(step->kind());
+            ScriptedInput input(&answers);
+            HeadlessIO io(input);
+            StepState &state = run.state(run.add(*step));
+            measure(string("step/") + stepKindName(step->kind()) + "/execute", 0, [&](uint64_t n)
+                    {
+                        for (uint64_t i = 0; i < n; i++)
+                        {
+                            input.rewind();
+                            step->execute(state, io, run).get();
+                        } });
+        }
+    }
+
+    void measureLookup()
+    {
+        FlowManager manager;
+        size_t count = 10000 * static_cast<size_t>(options.scale);
+        vector<string> names, missing;
+        for (size_t i = 0; i < count; i++)
+        {
+            auto flow = make_unique<FlowBuilder>();
+            flow->setName("flow" + to_string(i));
+            names.push_back(flow->getName());
+            missing.push_back("missing" + to_string(i));
+            manager.addFlow(move(flow));
+        }
+        size_t found = 0;
+        measure("flow/find_hit", 0, [&](uint64_t n)
                 {
-                    k = 0;
-                }
-                else
+                    for (uint64_t i = 0; i < n; i++)
+                        found += manager.findFlow(names[i % count]) != nullptr; });
+        measure("flow/find_miss", 0, [&](uint64_t n)
                 {
-                    cout << "Invalid answer. Try again." << endl;
-                }
+                    for (uint64_t i = 0; i < n; i++)
+                        found += manager.findFlow(missing[i % count]) != nullptr; });
+        if (found == 0 && options.filter.empty())
+            cout << "Flow lookup found nothing" << endl;
+    }
+
+#ifndef _WIN32
+    // Fisierul citit in loturi de Window cereri, cu bufferele comune ale backend-ului
+    static uint64_t readWith(AsyncIO &asyncIO, const string &fileName)
+    {
+        constexpr size_t Window = 8;
+        int fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return 0;
+        uint64_t size = fileSize(fileName), requested = 0, total = 0;
+        AsyncIO::Buffer buffers[Window];
+        for (auto &buffer : buffers)
+            buffer = asyncIO.acquire();
+        while (requested < size)
+        {
+            AsyncIO::Request batch[Window];
+            size_t count = 0;
+            for (; count < Window && requested < size; count++)
+            {
+                size_t length = static_cast<size_t>(min<uint64_t>(AsyncIO::BufferSize, size - requested));
+                batch[count] = {fd, buffers[count].data, length, requested, false, buffers[count].index};
+                requested += length;
             }
+            for (auto &result : asyncIO.submit(batch, count))
+                total += static_cast<uint64_t>(max<int64_t>(result.get(), 0));
         }
-        endStep->execute();
-        endStep->displayProgress();
-        return Allsteps;
+        for (auto &buffer : buffers)
+            asyncIO.release(buffer);
+        ::close(fd);
+        return total;
     }
+#endif
 
-    void runflow(vector<FlowStep *> allSteps)
+    void measureReading(const FlowDefinition &definition)
     {
-        timesStarted++;
-        cout << "Flow '" << name << "' started." << endl;
-        int choose;
-        for (auto &step : allSteps)
+        const DisplaySteps *display = nullptr;
+        for (auto &step : definition.steps)
         {
-            int obs = 1;
-            TotalErrors = TotalErrors + step->getError();
-            cout << "Step: " << step->getName() << endl;
-            cout << "Choose: " << endl
-                 << "1. You complete the step action and select the next one " << endl
-                 << "2. Skip the step" << endl;
-            while (obs == 1)
-            {
-                cin >> choose;
-                if (choose == 1)
+            if (step->kind() == StepKind::Display)
+                display = static_cast<const DisplaySteps *>(step.get());
+        }
+        vector<string> noAnswers;
+        ScriptedInput input(&noAnswers);
+        HeadlessIO io(input);
+        FlowRun run;
+        StepState &scratch = run.state(run.add(*display));
+        DisplaySteps::State &state = static_cast<DisplaySteps::State &>(run.state(run.add(*display)));
+        state.step = 6;
+        state.fileName = textFile;
+
+        double textBytes = static_cast<double>(fileSize(textFile));
+        double csvBytes = static_cast<double>(fileSize(csvFile));
+        measure("read/text_file", textBytes, [&](uint64_t n)
                 {
-                    step->displayProgress();
-                    obs = 0;
-                }
-                else if (choose == 2)
+                    for (uint64_t i = 0; i < n; i++)
+                        display->readFromTextFile(textFile, scratch, io); });
+        measure("read/csv_file", csvBytes, [&](uint64_t n)
                 {
-                    obs = 0;
-                    NrScreenSkipped++;
-                }
-                else
+                    for (uint64_t i = 0; i < n; i++)
+                        display->readFromCsvFile(csvFile, scratch, io); });
+        measure("read/extract_info", textBytes, [&](uint64_t n)
                 {
-                    cout << "Invalid answer. Try again." << endl;
-                    obs = 1;
-                }
-            }
+                    for (uint64_t i = 0; i < n; i++)
+                        display->extractInfo(state); });
+        measure("read/stream_info", textBytes, [&](uint64_t n)
+                {
+                    for (uint64_t i = 0; i < n; i++)
+                    {
+                        ChunkPipe pipe([](string_view)
+                                       { return true; });
+                        display->streamInfo(state, pipe);
+                        pipe.finish();
+                    } });
+
+#ifndef _WIN32
+        for (auto backend : {AsyncIO::Backend::Uring, AsyncIO::Backend::Threads})
+        {
+            AsyncIO asyncIO(backend);
+            if (asyncIO.backend() != backend)
+                continue; // fara io_uring pe masina asta
+            measure(string("io/read_") + asyncIO.name(), textBytes, [&](uint64_t n)
+                    {
+                        for (uint64_t i = 0; i < n; i++)
+                            readWith(asyncIO, textFile); });
         }
-        cout << "Flow '" << name << "' completed." << endl;
-        timesCompleted++;
+#endif
+
+        stringstream buffer;
+        buffer << ifstream(csvFile, ios::binary).rdbuf();
+        string content = buffer.str();
+        measure("csv/parse", csvBytes, [&](uint64_t n)
+                {
+                    for (uint64_t i = 0; i < n; i++)
+                        CsvTable::parse(content); });
 
-        cout << "Times Started: " << timesStarted << endl;
-        cout << "Times Completed: " << timesCompleted << endl;
-        cout << "Number of screens skipped: " << NrScreenSkipped << endl;
-        cout << "Mean of errors: " << TotalErrors / allSteps.size() << endl;
+        stringstream textBuffer;
+        textBuffer << ifstream(textFile, ios::binary).rdbuf();
+        string text = textBuffer.str();
+        measure("words/count", textBytes, [&](uint64_t n)
+                {
+                    for (uint64_t i = 0; i < n; i++)
+                        WordCounts::count(text); });
     }
-};
 
-class FlowManager
-{
-private:
-    vector<FlowBuilder> flows;
+    void measureOutput(const FlowDefinition &definition)
+    {
+        const FlowStep *title = nullptr;
+        const DisplaySteps *display = nullptr;
+        for (auto &step : definition.steps)
+        {
+            if (step->kind() == StepKind::Title)
+                title = step.get();
+            else if (step->kind() == StepKind::Display)
+                display = static_cast<const DisplaySteps *>(step.get());
+        }
+        const OutputStep &output = *definition.outputStep;
 
-public:
-    void deleteFlow()
+        FlowRun run;
+        vector<string> answers = script(StepKind::Title);
+        ScriptedInput input(&answers);
+        HeadlessIO io(input);
+        StepRun titleRun{title, &run.state(run.add(*title))};
+        title->execute(*titleRun.state, io, run).get();
+        StepRun displayRun{display, &run.state(run.add(*display))};
+        DisplaySteps::State &shown = static_cast<DisplaySteps::State &>(*displayRun.state);
+        shown.step = 6;
+        shown.fileName = smallTextFile;
+        OutputStep::State &data = static_cast<OutputStep::State &>(run.state(run.add(output)));
+        data.nameOfFile = outputName;
+
+        measure("output/append_record", static_cast<double>(title->extractInfo(*titleRun.state).size() + 1), [&](uint64_t n)
+                {
+                    for (uint64_t i = 0; i < n; i++)
+                        output.generateOutputFile(titleRun, data); });
+        measure("output/append_file", static_cast<double>(fileSize(smallTextFile) + 1), [&](uint64_t n)
+                {
+                    for (uint64_t i = 0; i < n; i++)
+                        output.generateOutputFile(displayRun, data); });
+        if (data.writeFailed)
+            cout << "Writing " << outputName << ".txt failed" << endl;
+    }
+
+    void measureFlow()
     {
-        string flowName;
-        cout << "Please enter the name of the flow you want to delete: " << endl;
-        cout << "Name: " << endl;
-        cin >> flowName;
-        auto found = find_if(flows.begin(), flows.end(), [flowName](const FlowBuilder &flow)
-                             { return flow.getName() == flowName; });
+        vector<string> answers = flowScript();
+        RunResult check = RunResult::run(answers);
+        if (!check.completed || check.errors != 0)
+        {
+            cout << "The benchmark flow did not complete" << endl;
+            return;
+        }
+        measure("flow/headless_run", 0, [&](uint64_t n)
+                {
+                    for (uint64_t i = 0; i < n; i++)
+                        RunResult::run(answers); });
+        // aceleasi rulari, toate deschise deodata pe firul unei bucle, cu raspunsurile date pe rand
+        measure("flow/session_run", 0, [&](uint64_t n)
+                {
+                    FlowSessions sessions;
+                    vector<size_t> ids;
+                    for (uint64_t i = 0; i < n; i++)
+                        ids.push_back(sessions.open());
+                    for (const string &answer : answers)
+                    {
+                        for (size_t id : ids)
+                            sessions.deliver(id, answer);
+                    }
+                    sessions.finish(); });
+
+        shared_ptr<const Expression> compiled = Expression::cached("(a + b) * max(c, d) / e");
+        double values[5] = {1.5, 2.5, 3.0, 4.0, 2.0};
+        bool divisionByZero = false;
+        volatile double sink = 0;
+        measure("expression/evaluate", 0, [&](uint64_t n)
+                {
+                    for (uint64_t i = 0; i < n; i++)
+                    {
+                        values[0] = static_cast<double>(i & 1023);
+                        sink = compiled->evaluate(values, divisionByZero);
+                    } });
+        (void)sink;
+    }
 
-        if (found != flows.end())
+    // Descrieri de cate 20-200 de caractere, doar ASCII sau cu diacritice
+    void measureValidation()
+    {
+        uint64_t seed = 0x2545F4914F6CDD1Dull;
+        vector<string> ascii, romanian;
+        for (int i = 0; i < 1024; i++)
         {
-            flows.erase(found);
-            cout << "Flow '" << flowName << "' deleted." << endl;
+            string plain, accented;
+            size_t words = 3 + nextRandom(seed) % 28;
+            for (size_t w = 0; w < words; w++)
+            {
+                const char *next = word(seed);
+                plain += next;
+                plain += ' ';
+                accented += next;
+                accented += nextRandom(seed) % 2 ? "ă " : "ș ";
+            }
+            ascii.push_back(plain);
+            romanian.push_back(accented);
         }
-        else
+        size_t valid = 0;
+        for (auto [name, inputs] : {pair{"validate/ascii_description", &ascii}, pair{"validate/romanian_description", &romanian}})
         {
-            cout << "Flow '" << flowName << "' not found." << endl;
+            double bytes = 0;
+            for (auto &input : *inputs)
+                bytes += input.size();
+            measure(name, bytes / inputs->size(), [&](uint64_t n)
+                    {
+                        for (uint64_t i = 0; i < n; i++)
+                            valid += ValidText<InputRules::description>::check((*inputs)[i % inputs->size()]); });
         }
+        if (valid == 0 && options.filter.empty())
+            cout << "No description was valid" << endl;
     }
 
-    void runFlow(vector<FlowStep *> allSteps)
+    // Intregi si numere cu zecimale sau exponent, cate unul pe linie (NumberInputStep, file:<nume>)
+    void measureNumbers()
     {
-        string flowName;
-        cout << "Please enter the name of the flow you want to run: " << endl;
-        cout << "Name: " << endl;
-        cin >> flowName;
-        auto found = find_if(flows.begin(), flows.end(), [&flowName](const FlowBuilder &flow)
-                             { return flow.getName() == flowName; });
-
-        if (found != flows.end())
+        uint64_t seed = 0xBF58476D1CE4E5B9ull;
+        string text;
+        char number[32];
+        while (text.size() < (static_cast<size_t>(options.scale) << 23))
         {
-            found->runflow(allSteps);
+            uint64_t r = nextRandom(seed);
+            if (r % 2 == 0)
+                text += to_string(static_cast<int64_t>(r % 2000000) - 1000000);
+            else
+                text.append(number, to_chars(number, number + sizeof(number), static_cast<double>(r >> 11) * 1e-9).ptr);
+            text += '\n';
         }
-        else
+        size_t parsed = 0;
+        measure("numbers/parse", static_cast<double>(text.size()), [&](uint64_t n)
+                {
+                    for (uint64_t i = 0; i < n; i++)
+                        parsed += NumberList::parse(text)->values.size(); });
+        if (parsed == 0 && options.filter.empty())
+            cout << "No numbers were parsed" << endl;
+    }
+
+    void writeResults(ostream &out) const
+    {
+        out << "{\n  \"suite\": \"flow\",\n  \"version\": 1,\n  \"scale\": " << options.scale << ",\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
         {
-            cout << "Flow '" << flowName << "' not found." << endl;
+            const Result &result = results[i];
+            out << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations << ", \"ns_per_op\": " << result.nsPerOp;
+            if (result.bytesPerOp != 0)
+                out << ", \"mb_per_second\": " << megabytesPerSecond(result);
+            out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
         }
+        out << "  ]\n}\n";
     }
 
-    void interface()
+    // Perechile name / ns_per_op dintr-un fisier scris de writeResults
+    static bool readBaseline(const string &fileName, unordered_map<string, double> &baseline)
     {
-        FlowBuilder flow;
-        int choice, k = 1;
-        string answer;
-        vector<FlowStep *> allSteps;
-
-        cout << "\t\t\t\t______________________________________\n";
-        cout << "\t\t\t\t                                      \n";
-        cout << "\t\t\t\t              Welcome, user!          \n";
-        cout << "\t\t\t\t                                      \n";
-        cout << "\t\t\t\t______________________________________\n";
-        cout << "\t\t\t\t                                      \n";
-        cout << "\t\t\t\t|    1) Create flow       |\n";
-        cout << "\t\t\t\t|                         |\n";
-        cout << "\t\t\t\t|    2) Delete flow       |\n";
-        cout << "\t\t\t\t|                         |\n";
-        cout << "\t\t\t\t|    3) Run flow          |\n";
-        cout << "\t\t\t\t|                         |\n";
+        ifstream file(fileName);
+        if (!file.is_open())
+            return false;
+        stringstream buffer;
+        buffer << file.rdbuf();
+        string content = buffer.str();
+        const string nameKey = "\"name\": \"", timeKey = "\"ns_per_op\": ";
+        for (size_t at = content.find(nameKey); at != string::npos; at = content.find(nameKey, at))
+        {
+            at += nameKey.size();
+            size_t nameEnd = content.find('"', at);
+            size_t time = content.find(timeKey, nameEnd);
+            if (nameEnd == string::npos || time == string::npos)
+                break;
+            baseline[content.substr(at, nameEnd - at)] = strtod(content.c_str() + time + timeKey.size(), nullptr);
+        }
+        return true;
+    }
 
-        while (k == 1)
+    // Intoarce numarul de cazuri mai lente decat referinta cu mai mult de threshold procente
+    int compare(const unordered_map<string, double> &baseline) const
+    {
+        int regressions = 0;
+        cout << endl
+             << "Compared with " << options.baselineFile << " (threshold " << options.threshold << "%):" << endl;
+        for (auto &result : results)
         {
-            cin.ignore();
-            cout << "Do you want to run, create or delete flows? \n";
-            cout << "Choose yes / no ";
-            getline(cin, answer);
-            if (answer == "yes")
+            auto found = baseline.find(result.name);
+            if (found == baseline.end() || found->second <= 0)
             {
-                cout << "\n\t\t\t Please select ";
-                cin >> choice;
-                switch (choice)
-                {
-                case 1:
-                    cin.ignore();
-                    allSteps = flow.execute();
-
-                    flows.push_back(flow);
-                    break;
-                case 2:
-                    cin.ignore();
-                    deleteFlow();
-                    break;
-                case 3:
-                    cin.ignore();
-                    runFlow(allSteps);
-                    break;
-                default:
-                    cout << "\t\t\t Please select from the options given above \n"
-                         << endl;
-                }
+                cout << "\t" << result.name << ": not in baseline" << endl;
+                continue;
             }
-            else if (answer == "no")
+            double change = (result.nsPerOp / found->second - 1) * 100;
+            cout << "\t" << result.name << ": " << found->second << " -> " << result.nsPerOp << " ns/op ("
+                 << (change >= 0 ? "+" : "") << change << "%)";
+            if (change > options.threshold)
             {
-                k = 0;
+                cout << " REGRESSION";
+                regressions++;
             }
+            else if (change < -options.threshold)
+                cout << " improved";
+            cout << endl;
+        }
+        return regressions;
+    }
 
-            else
+public:
+    BenchmarkSuite(Options Options) : options(move(Options)) {}
+
+    const vector<Result> &getResults() const
+    {
+        return results;
+    }
+
+    // 0 daca nu sunt regresii, 1 daca datele sau rezultatele nu pot fi scrise, 2 daca exista regresii
+    int run()
+    {
+        unordered_map<string, double> baseline;
+        if (!options.baselineFile.empty() && !readBaseline(options.baselineFile, baseline))
+        {
+            cout << "Cannot read baseline " << options.baselineFile << endl;
+            return 1;
+        }
+        size_t scale = static_cast<size_t>(options.scale);
+        if (!generateText(textFile, scale << 24) || !generateText(smallTextFile, 4096) || !generateCsv(csvFile, 200000 * scale))
+        {
+            cout << "Cannot generate benchmark data in the current directory" << endl;
+            return 1;
+        }
+
+        shared_ptr<const FlowDefinition> definition = FlowDefinition::standard();
+        measureSteps(*definition);
+        measureLookup();
+        measureReading(*definition);
+        measureOutput(*definition);
+        measureFlow();
+        measureValidation();
+        measureNumbers();
+
+        OutputWriter::closeAll();
+        for (const string &fileName : {textFile, smallTextFile, csvFile, outputName + ".txt"})
+            remove(fileName.c_str());
+
+        if (!options.resultsFile.empty())
+        {
+            ofstream file(options.resultsFile, ios::out | ios::trunc);
+            writeResults(file);
+            if (!file)
             {
-                cout << "Invalid answer. Try again." << endl;
+                cout << "Cannot write results to " << options.resultsFile << endl;
+                return 1;
             }
+            cout << "Results written to " << options.resultsFile << endl;
         }
+        if (!options.baselineFile.empty() && compare(baseline) != 0)
+            return 2;
+        return 0;
     }
 };
 
-int main()
+// Compara expresia compilata cu lantul if/else pe textul operatiei, pentru (a + b) * max(c, d) / e
+void benchmarkCalculus(long evaluations)
+{
+    auto chain = [](const string &operation, float x, float y)
+    {
+        if (operation == "+")
+            return x + y;
+        else if (operation == "-")
+            return x - y;
+        else if (operation == "*")
+            return x * y;
+        else if (operation == "/")
+            return y != 0 ? x / y : 0.0f;
+        else if (operation == "min")
+            return min(x, y);
+        else if (operation == "max")
+            return max(x, y);
+        return 0.0f;
+    };
+    const string operations[] = {"+", "max", "*", "/"};
+    float inputs[5] = {1.5f, 2.5f, 3.0f, 4.0f, 2.0f};
+    volatile float sink = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (long i = 0; i < evaluations; i++)
+    {
+        inputs[0] = static_cast<float>(i & 1023);
+        string operation = operations[0]; // ca in pas: operatia e citita ca text la fiecare calcul
+        float sum = chain(operation, inputs[0], inputs[1]);
+        operation = operations[1];
+        float larger = chain(operation, inputs[2], inputs[3]);
+        operation = operations[2];
+        float product = chain(operation, sum, larger);
+        operation = operations[3];
+        sink = chain(operation, product, inputs[4]);
+    }
+    double chainSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    shared_ptr<const Expression> compiled = Expression::cached("(a + b) * max(c, d) / e");
+    double values[5] = {1.5, 2.5, 3.0, 4.0, 2.0};
+    bool divisionByZero = false;
+    start = chrono::steady_clock::now();
+    for (long i = 0; i < evaluations; i++)
+    {
+        values[0] = static_cast<double>(i & 1023);
+        sink = static_cast<float>(compiled->evaluate(values, divisionByZero));
+    }
+    double compiledSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    (void)sink;
+
+    cout << "Expression: (a + b) * max(c, d) / e, " << evaluations << " evaluations" << endl;
+    cout << "If/else chain on operation text: " << evaluations / chainSeconds << " evaluations per second" << endl;
+    cout << "Compiled expression: " << evaluations / compiledSeconds << " evaluations per second" << endl;
+}
+
+int main(int argc, char *argv[])
 {
+    AsyncSink::attachConsole();
     FlowManager flow;
-    flow.interface();
+    string batchFile, loadFile, saveFile, metricsFile, historyPrefix, historyFlow, resumeName;
+    int repeat = 1, threads = 1, sessions = 1, historyDays = 7, retentionDays = 0;
+    DurabilityPolicy durability;
+    BenchmarkSuite::Options bench;
+    bool benchmark = false;
+    for (int i = 1; i < argc; i += 2)
+    {
+        string option = argv[i];
+        if (i + 1 == argc) // toate optiunile au o valoare
+        {
+            cout << "Missing value for option " << option << endl;
+            return 1;
+        }
+        if (option == "--batch")
+            batchFile = argv[i + 1];
+        else if (option == "--repeat")
+            repeat = max(1, atoi(argv[i + 1]));
+        else if (option == "--threads")
+            threads = max(1, atoi(argv[i + 1]));
+        else if (option == "--sessions")
+            sessions = max(1, atoi(argv[i + 1]));
+        else if (option == "--load")
+            loadFile = argv[i + 1];
+        else if (option == "--save")
+            saveFile = argv[i + 1];
+        else if (option == "--durability")
+        {
+            string mode = argv[i + 1];
+            if (mode == "none")
+                durability.mode = Durability::None;
+            else if (mode == "periodic")
+                durability.mode = Durability::Periodic;
+            else if (mode == "group")
+                durability.mode = Durability::GroupCommit;
+            else
+            {
+                cout << "Unknown durability " << mode << " (none / periodic / group)" << endl;
+                return 1;
+            }
+        }
+        else if (option == "--sync-records")
+            durability.everyRecords = max(1, atoi(argv[i + 1]));
+        else if (option == "--sync-ms")
+            durability.everyMs = max(1, atoi(argv[i + 1]));
+        else if (option == "--metrics")
+            metricsFile = argv[i + 1];
+        else if (option == "--log-level")
+        {
+            LogLevel level;
+            if (!Log::parseLevel(argv[i + 1], level))
+            {
+                cout << "Unknown log level " << argv[i + 1] << " (quiet / error / warning / info / debug)" << endl;
+                return 1;
+            }
+            Log::setLevel(level);
+        }
+        else if (option == "--log-file")
+        {
+            if (!Log::openFile(argv[i + 1]))
+            {
+                cout << "Cannot open log file " << argv[i + 1] << endl;
+                return 1;
+            }
+        }
+        else if (option == "--history")
+            historyPrefix = argv[i + 1];
+        else if (option == "--history-report")
+            historyFlow = argv[i + 1];
+        else if (option == "--history-days")
+            historyDays = max(0, atoi(argv[i + 1]));
+        else if (option == "--history-retention")
+            retentionDays = max(0, atoi(argv[i + 1]));
+        else if (option == "--checkpoint")
+            FlowCheckpoint::setDirectory(argv[i + 1]);
+        else if (option == "--resume")
+            resumeName = argv[i + 1];
+#ifndef _WIN32
+        else if (option == "--io")
+        {
+            string backend = argv[i + 1];
+            if (backend == "uring")
+                AsyncIO::select(AsyncIO::Backend::Uring);
+            else if (backend == "threads")
+                AsyncIO::select(AsyncIO::Backend::Threads);
+            else
+            {
+                cout << "Unknown I/O backend " << backend << " (uring / threads)" << endl;
+                return 1;
+            }
+        }
+#endif
+        else if (option == "--read-threads")
+            FileSet::setConcurrency(static_cast<size_t>(max(1, atoi(argv[i + 1]))));
+        else if (option == "--cache-mb")
+            WorkCache::shared().setLimit(static_cast<size_t>(max(0, atoi(argv[i + 1]))) << 20);
+        else if (option == "--bench")
+        {
+            bench.resultsFile = argv[i + 1];
+            benchmark = true;
+        }
+        else if (option == "--bench-baseline")
+        {
+            bench.baselineFile = argv[i + 1];
+            benchmark = true;
+        }
+        else if (option == "--bench-filter")
+            bench.filter = argv[i + 1];
+        else if (option == "--bench-threshold")
+            bench.threshold = atof(argv[i + 1]);
+        else if (option == "--bench-seconds")
+            bench.seconds = max(0.001, atof(argv[i + 1]));
+        else if (option == "--bench-scale")
+            bench.scale = max(1, atoi(argv[i + 1]));
+        else if (option == "--bench-calculus")
+        {
+            benchmarkCalculus(max(1L, atol(argv[i + 1])));
+            return 0;
+        }
+        else
+        {
+            cout << "Unknown option " << option << endl;
+            return 1;
+        }
+    }
+    OutputWriter::setDefaultPolicy(durability);
+    if (benchmark)
+        return BenchmarkSuite(bench).run();
+    if (!historyPrefix.empty())
+    {
+        string error;
+        if (!RunHistory::shared().open(historyPrefix, error, retentionDays))
+        {
+            cout << error << endl;
+            return 1;
+        }
+    }
+    if (!historyFlow.empty())
+    {
+        flow.historyReport(historyFlow, historyDays);
+        OutputWriter::closeAll();
+        return 0;
+    }
+    if (!loadFile.empty())
+        flow.loadSnapshot(loadFile);
+    if (!batchFile.empty())
+    {
+        flow.runBatch(batchFile, repeat, threads, sessions);
+        if (!saveFile.empty())
+            flow.saveSnapshot(saveFile);
+        if (!metricsFile.empty())
+            flow.exportMetrics(metricsFile);
+        OutputWriter::closeAll();
+        return 0;
+    }
+    try
+    {
+        if (!resumeName.empty())
+            flow.resumeFlow(resumeName);
+        flow.interface();
+    }
+    catch (const InputExhausted &)
+    {
+        cout << endl
+             << "Input closed. Exiting." << endl;
+    }
+    if (!metricsFile.empty())
+        flow.exportMetrics(metricsFile);
+    // Scriitorii se inchid aici, cat timp Metrics si firele lor de scriere exista inca, nu la distrugerea statica
+    OutputWriter::closeAll();
 
     return 0;
 }
\ No newline at end of file